@@ -0,0 +1,29 @@
+#ifndef _SDKCONFIG_H
+#define _SDKCONFIG_H
+
+/*configurazione del firmware su linux: valori di default di Kconfig.projbuild, broker locale*/
+
+#define CONFIG_BROKER_URL "mqtt://localhost:1883"
+
+#define CONFIG_THERMO_PUBLISH_COALESCE_WINDOW_MS 50
+#define CONFIG_THERMO_COMMAND_POOL_SLOTS 4
+#define CONFIG_THERMO_COMMAND_SLOT_SIZE 1280
+#define CONFIG_THERMO_OFFLINE_LOG_EVENTS 256
+#define CONFIG_THERMO_OFFLINE_REPLAY_INTERVAL_MS 500
+#define CONFIG_THERMO_SETTINGS_COMMIT_DELAY_MS 1000     //salvataggio rapido per il test di integrazione
+#define CONFIG_THERMO_SETTINGS_COMMIT_MAX_DELAY_MS 60000
+#define CONFIG_THERMO_RECONNECT_MIN_DELAY_MS 1000
+#define CONFIG_THERMO_RECONNECT_MAX_DELAY_MS 300000
+#define CONFIG_THERMO_DHT_AGGREGATE_AVERAGE 1
+#define CONFIG_THERMO_CONTROL_HYSTERESIS 1
+#define CONFIG_THERMO_TPI_CYCLE_S 600
+#define CONFIG_THERMO_TPI_KP 100
+#define CONFIG_THERMO_TPI_KI 50
+#define CONFIG_THERMO_TPI_MIN_ON_S 120
+#define CONFIG_THERMO_TPI_MIN_OFF_S 120
+#define CONFIG_THERMO_OPTIMUM_START 1
+#define CONFIG_THERMO_OPTIMUM_START_MAX_LEAD_MIN 180
+#define CONFIG_THERMO_OPTIMUM_START_MIN_RUN_MIN 20
+#define CONFIG_THERMO_METRICS_INTERVAL_S 60
+
+#endif
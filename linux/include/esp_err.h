@@ -0,0 +1,17 @@
+#ifndef _ESP_ERR_H
+#define _ESP_ERR_H
+
+#include <stdint.h>
+
+/*codici di errore dell'sdk esp8266 usati dal firmware*/
+
+typedef int32_t esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NVS_BASE 0x1100
+#define ESP_ERR_NVS_NOT_FOUND (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_INVALID_LENGTH (ESP_ERR_NVS_BASE + 0x0c)
+#define ESP_ERR_NVS_NO_FREE_PAGES (ESP_ERR_NVS_BASE + 0x0d)
+
+#endif
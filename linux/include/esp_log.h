@@ -0,0 +1,17 @@
+#ifndef _ESP_LOG_H
+#define _ESP_LOG_H
+
+#include <stdio.h>
+
+/*log dell'sdk esp8266 su stdout, stesso formato a livello e tag, i messaggi di debug sono omessi come nella
+  configurazione di default del firmware*/
+
+#define _ESP_LOG(level, tag, format, ...) printf(level " %s" format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) _ESP_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) _ESP_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) _ESP_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { } while (0)
+#define ESP_LOGV(tag, format, ...) do { } while (0)
+
+#endif
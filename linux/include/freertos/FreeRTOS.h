@@ -0,0 +1,3 @@
+/*percorso degli header di freertos nell'sdk esp8266, rimandato agli header del kernel*/
+
+#include <FreeRTOS.h>
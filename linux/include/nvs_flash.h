@@ -0,0 +1,11 @@
+#ifndef _NVS_FLASH_H
+#define _NVS_FLASH_H
+
+#include "esp_err.h"
+
+/*inizializzazione della nvs su file, crea la cartella THERMO_NVS_DIR (default "nvs")*/
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+
+#endif
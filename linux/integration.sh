@@ -0,0 +1,98 @@
+#!/bin/sh
+# test di integrazione del firmware su linux contro un broker mosquitto locale già avviato (porta 1883):
+# connessione e stato iniziale, comandi mqtt e decisione del relè, salvataggio delle impostazioni in nvs e ripristino
+# al riavvio, last will alla chiusura del processo
+#
+#   linux/integration.sh build-linux/thermostat
+
+set -eu
+
+FIRMWARE=$(realpath "${1:-build-linux/thermostat}")
+WORK=$(mktemp -d)
+TIMEOUT=60
+FIRMWARE_PID=
+SUB_PID=
+
+export THERMO_SENSOR_FILE="$WORK/sensor"
+export THERMO_NVS_DIR="$WORK/nvs"
+
+cleanup() {
+    [ -n "$FIRMWARE_PID" ] && kill "$FIRMWARE_PID" 2>/dev/null || true
+    [ -n "$SUB_PID" ] && kill "$SUB_PID" 2>/dev/null || true
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+fail() {
+    echo "FAIL: $1"
+    echo "--- firmware"
+    cat "$WORK/firmware.log"
+    echo "--- messaggi"
+    cat "$WORK/messages.log"
+    exit 1
+}
+
+#attesa di un messaggio sul topic dati che contiene $1, pubblicato dopo la riga $2 del log dei messaggi
+expect() {
+    for i in $(seq $TIMEOUT); do
+        tail -n +"$(($2 + 1))" "$WORK/messages.log" | grep -q "$1" && return 0
+        sleep 1
+    done
+    fail "no message with $1"
+}
+
+mark() {
+    wc -l < "$WORK/messages.log"
+}
+
+start_firmware() {
+    "$FIRMWARE" >> "$WORK/firmware.log" 2>&1 &
+    FIRMWARE_PID=$!
+}
+
+stop_firmware() {
+    kill "$FIRMWARE_PID"
+    wait "$FIRMWARE_PID" 2>/dev/null || true
+    FIRMWARE_PID=
+}
+
+echo "19.0 50.0" > "$THERMO_SENSOR_FILE"
+: > "$WORK/firmware.log"
+mosquitto_sub -h localhost -t tamba/test/dati > "$WORK/messages.log" &
+SUB_PID=$!
+sleep 1
+
+start_firmware
+expect '"nodeOnline":true' 0
+expect '"currentTemp":19' 0
+
+#acceso con target sopra la temperatura misurata
+MARK=$(mark)
+mosquitto_pub -h localhost -t tamba/test/comandi -m '{"mainSwitch":true,"targetTemp":22,"deltaTemp":0.5}'
+expect '"thermoOn":true' "$MARK"
+
+#target sotto la temperatura misurata, spento
+MARK=$(mark)
+mosquitto_pub -h localhost -t tamba/test/comandi -m '{"targetTemp":18}'
+expect '"thermoOn":false' "$MARK"
+
+#salvataggio ritardato delle impostazioni, poi riavvio
+for i in $(seq $TIMEOUT); do
+    [ -f "$THERMO_NVS_DIR/thermostat.settings" ] && grep -q "settings saved" "$WORK/firmware.log" && break
+    sleep 1
+done
+[ -f "$THERMO_NVS_DIR/thermostat.settings" ] || fail "settings not saved"
+
+#la chiusura del processo senza disconnessione fa pubblicare la last will al broker
+MARK=$(mark)
+stop_firmware
+expect '"nodeOnline":false' "$MARK"
+
+MARK=$(mark)
+start_firmware
+expect '"nodeOnline":true' "$MARK"
+mosquitto_pub -h localhost -t tamba/test/comandi -m '{"updateRequest":true}'
+expect '"targetTemp":18' "$MARK"
+expect '"mainSwitch":true' "$MARK"
+
+echo "integration test passed"
@@ -0,0 +1,24 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*avvio del firmware su linux: app_main crea i task come nell'sdk esp8266, poi parte lo scheduler del port posix*/
+
+void app_main(void);
+
+void vAssertCalled(const char *file, unsigned long line)
+{
+    fprintf(stderr, "assert failed: %s:%lu\n", file, line);
+    abort();
+}
+
+int main(void)
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);   //log leggibile riga per riga anche su file o pipe
+
+    app_main();
+    vTaskStartScheduler();
+    return 1;
+}
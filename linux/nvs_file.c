@@ -0,0 +1,123 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+
+/*nvs dell'sdk esp8266 su file per il firmware su linux: ogni chiave è il file <namespace>.<chiave> nella cartella
+  THERMO_NVS_DIR, scritto su un file temporaneo e rinominato, per cui un riavvio a metà scrittura lascia il valore
+  precedente. i namespace sono pochi e mai chiusi, l'handle è l'indice nella tabella*/
+
+#define NVS_DIR_ENV "THERMO_NVS_DIR"
+#define NVS_DIR_DEFAULT "nvs"
+#define NVS_MAX_NAMESPACES 4
+#define NVS_NAME_SIZE 16
+#define NVS_PATH_SIZE 256
+
+static char nvs_namespaces[NVS_MAX_NAMESPACES][NVS_NAME_SIZE];
+static int nvs_namespaces_count = 0;
+
+static const char *nvs_dir(void)
+{
+    const char *dir = getenv(NVS_DIR_ENV);
+
+    return dir ? dir : NVS_DIR_DEFAULT;
+}
+
+static void nvs_path(nvs_handle handle, const char *key, const char *suffix, char *path)
+{
+    snprintf(path, NVS_PATH_SIZE, "%s/%s.%s%s", nvs_dir(), nvs_namespaces[handle], key, suffix);
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    if (mkdir(nvs_dir(), 0755) != 0 && errno != EEXIST)
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode open_mode, nvs_handle *out_handle)
+{
+    if (strlen(name) >= NVS_NAME_SIZE)
+        return ESP_FAIL;
+
+    for (int i = 0; i < nvs_namespaces_count; i++)
+    {
+        if (strcmp(nvs_namespaces[i], name) == 0)
+        {
+            *out_handle = i;
+            return ESP_OK;
+        }
+    }
+
+    if (nvs_namespaces_count == NVS_MAX_NAMESPACES)
+        return ESP_FAIL;
+
+    strcpy(nvs_namespaces[nvs_namespaces_count], name);
+    *out_handle = nvs_namespaces_count++;
+    return ESP_OK;
+}
+
+//come nell'sdk, un blob più grande del buffer non viene letto
+esp_err_t nvs_get_blob(nvs_handle handle, const char *key, void *out_value, size_t *length)
+{
+    char path[NVS_PATH_SIZE];
+    FILE *file;
+    size_t read;
+    int extra;
+
+    nvs_path(handle, key, "", path);
+    file = fopen(path, "rb");
+    if (!file)
+        return ESP_ERR_NVS_NOT_FOUND;
+
+    read = fread(out_value, 1, *length, file);
+    extra = fgetc(file);
+    fclose(file);
+
+    if (extra != EOF)
+        return ESP_ERR_NVS_INVALID_LENGTH;
+
+    *length = read;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char *key, const void *value, size_t length)
+{
+    char path[NVS_PATH_SIZE], temp_path[NVS_PATH_SIZE];
+    FILE *file;
+    bool ok;
+
+    nvs_path(handle, key, ".tmp", temp_path);
+    nvs_path(handle, key, "", path);
+
+    file = fopen(temp_path, "wb");
+    if (!file)
+        return ESP_FAIL;
+
+    ok = fwrite(value, 1, length, file) == length;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(temp_path, path) != 0)
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+//le scritture sono già definitive
+esp_err_t nvs_commit(nvs_handle handle)
+{
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle handle)
+{
+}
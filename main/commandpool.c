@@ -0,0 +1,153 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+
+#include "commandpool.h"
+
+/*
+  pool statico di slot per i comandi mqtt in ingresso: l'inserimento non alloca e non blocca mai,
+  a pool pieno viene scartato il comando più vecchio ancora da elaborare (politica drop-oldest).
+  gli indici degli slot circolano tra una queue di slot liberi e una queue fifo di slot pronti,
+  il consumatore elabora il comando direttamente nello slot e lo restituisce con command_pool_release.
+  i frammenti sono prodotti da un solo task, il client mqtt, per cui la ricomposizione non richiede sincronizzazione
+*/
+
+static char _command_pool_slots[CONFIG_THERMO_COMMAND_POOL_SLOTS][CONFIG_THERMO_COMMAND_SLOT_SIZE];
+static QueueHandle_t _command_pool_free_queue;
+static QueueHandle_t _command_pool_ready_queue;
+static command_pool_stats_t _command_pool_stats;
+static int _command_pool_assembly_slot = -1;     //slot del messaggio frammentato in ricomposizione, -1 se nessuno
+static int _command_pool_assembly_len;
+static const char *_command_pool_tag = "COMMAND_POOL: ";
+
+/*creazione delle queue e inserimento di tutti gli slot tra quelli liberi*/
+
+bool command_pool_init(void)
+{
+    _command_pool_free_queue = xQueueCreate(CONFIG_THERMO_COMMAND_POOL_SLOTS, sizeof(int));
+    _command_pool_ready_queue = xQueueCreate(CONFIG_THERMO_COMMAND_POOL_SLOTS, sizeof(int));
+
+    if (!_command_pool_free_queue || !_command_pool_ready_queue)
+        return false;
+
+    for (int i = 0; i < CONFIG_THERMO_COMMAND_POOL_SLOTS; i++)
+        xQueueSend(_command_pool_free_queue, &i, 0);
+
+    return true;
+}
+
+/*ottiene uno slot libero, a pool pieno recupera lo slot del comando più vecchio non ancora elaborato. ritorna -1 se non disponibile*/
+
+static int _command_pool_take_slot(void)
+{
+    int slot;
+
+    if (xQueueReceive(_command_pool_free_queue, &slot, 0) == pdTRUE)
+        return slot;
+
+    if (xQueueReceive(_command_pool_ready_queue, &slot, 0) == pdTRUE)
+    {
+        _command_pool_stats.dropped_oldest++;
+        ESP_LOGE(_command_pool_tag, "pool full, oldest command dropped");
+        return slot;
+    }
+
+    return -1;
+}
+
+/*
+  accoda un frammento di comando, non bloccante. i frammenti di un messaggio arrivano in ordine e vengono ricomposti
+  direttamente in uno slot, che viene accodato solo quando il messaggio è completo: la dimensione dello slot è il limite massimo.
+  un messaggio non frammentato è un unico frammento con offset 0 e total_len pari a len. ritorna false se il frammento viene scartato
+*/
+
+bool command_pool_put_fragment(const char *data, const int len, const int offset, const int total_len)
+{
+    if (!_command_pool_ready_queue || len < 0 || total_len >= CONFIG_THERMO_COMMAND_SLOT_SIZE || offset + len > total_len)
+    {
+        if (offset == 0)
+        {
+            _command_pool_stats.rejected++;
+            ESP_LOGE(_command_pool_tag, "command rejected, length: %d", total_len);
+        }
+        return false;
+    }
+
+    if (offset == 0)
+    {
+        //nuovo messaggio: un messaggio precedente rimasto incompleto viene scartato
+        if (_command_pool_assembly_slot >= 0)
+        {
+            _command_pool_stats.incomplete++;
+            command_pool_release(_command_pool_assembly_slot);
+        }
+
+        _command_pool_assembly_slot = _command_pool_take_slot();
+        _command_pool_assembly_len = 0;
+
+        if (_command_pool_assembly_slot < 0)
+        {
+            _command_pool_stats.rejected++;
+            return false;
+        }
+    }
+
+    //frammento senza inizio del messaggio o non contiguo
+    else if (_command_pool_assembly_slot < 0 || offset != _command_pool_assembly_len)
+    {
+        if (_command_pool_assembly_slot >= 0)
+        {
+            _command_pool_stats.incomplete++;
+            command_pool_release(_command_pool_assembly_slot);
+            _command_pool_assembly_slot = -1;
+        }
+        return false;
+    }
+
+    memcpy(_command_pool_slots[_command_pool_assembly_slot] + offset, data, len);
+    _command_pool_assembly_len += len;
+
+    if (_command_pool_assembly_len == total_len)
+    {
+        _command_pool_slots[_command_pool_assembly_slot][total_len] = '\0';     //terminatore di stringa nel caso i dati in ingresso non siano null terminated
+        xQueueSend(_command_pool_ready_queue, &_command_pool_assembly_slot, 0);
+        _command_pool_assembly_slot = -1;
+        _command_pool_stats.received++;
+    }
+
+    return true;
+}
+
+/*attende il prossimo comando, ritorna l'indice dello slot da restituire con command_pool_release oppure -1 allo scadere dell'attesa*/
+
+int command_pool_receive(char **data, TickType_t ticks_to_wait)
+{
+    int slot;
+
+    if (xQueueReceive(_command_pool_ready_queue, &slot, ticks_to_wait) != pdTRUE)
+        return -1;
+
+    *data = _command_pool_slots[slot];
+    return slot;
+}
+
+/*restituisce al pool lo slot di un comando elaborato*/
+
+void command_pool_release(const int slot)
+{
+    xQueueSend(_command_pool_free_queue, &slot, 0);
+}
+
+/*comandi ricevuti e non ancora prelevati dal consumatore*/
+
+int command_pool_pending(void)
+{
+    return _command_pool_ready_queue ? (int)uxQueueMessagesWaiting(_command_pool_ready_queue) : 0;
+}
+
+void command_pool_get_stats(command_pool_stats_t *stats)
+{
+    *stats = _command_pool_stats;
+}
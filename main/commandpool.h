@@ -0,0 +1,26 @@
+#ifndef _COMMANDPOOL_H
+#define _COMMANDPOOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+/*contatori del pool dei comandi mqtt in ingresso*/
+
+typedef struct
+{
+    uint32_t received;          //comandi accodati
+    uint32_t dropped_oldest;    //comandi più vecchi scartati per fare posto a un nuovo comando
+    uint32_t rejected;          //comandi scartati perché più lunghi di uno slot o per pool non inizializzato
+    uint32_t incomplete;        //comandi frammentati scartati per frammenti mancanti o fuori ordine
+} command_pool_stats_t;
+
+bool command_pool_init(void);
+bool command_pool_put_fragment(const char *data, const int len, const int offset, const int total_len);
+int command_pool_receive(char **data, TickType_t ticks_to_wait);
+void command_pool_release(const int slot);
+int command_pool_pending(void);
+void command_pool_get_stats(command_pool_stats_t *stats);
+
+#endif
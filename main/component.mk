@@ -6,3 +6,6 @@
 # in the build directory. This behaviour is entirely configurable,
 # please read the ESP-IDF documents if you need to do this.
 #
+
+# implementazioni della piattaforma per test e simulazioni su host e per il firmware su linux, non fanno parte del firmware esp8266
+COMPONENT_OBJEXCLUDE := platform_posix.o platform_linux.o
@@ -5,90 +5,117 @@
 
 #include "dht.h"
 
-static dht_sensor_type _dht_sensor_type_configured;
-static gpio_num_t _dht_gpio_configured;
-static uint32_t _dht_wakeup_pulldown_time_ms_configured;
-static uint32_t _dht_safe_delay_ms_configured;
-static bool _dht_safe_mode_configured;
-static bool _dht_configuration_done = false;
-static volatile uint32_t _dht_prev_interrupt_time;
-static volatile int32_t _dht_serial_bit_number;
-static volatile uint32_t _dht_buffer[2];
+/*contesto di un sensore, ogni sensore ha il proprio buffer di ricezione e il proprio stato per l'ISR*/
+
+struct dht_sensor
+{
+    dht_sensor_type type;
+    gpio_num_t gpio;
+    uint32_t wakeup_pulldown_time_ms;
+    uint32_t wakeup_max_pulldown_us;
+    uint32_t safe_delay_us;
+    bool safe_mode;
+    bool measured;
+    int64_t last_measure_time;              //istante dell'ultima misurazione per la finestra di sicurezza, in us
+    int64_t wakeup_time;                    //istante in cui la linea dati è stata abbassata, in us
+    volatile uint32_t prev_interrupt_time;
+    volatile int32_t serial_bit_number;
+    volatile uint32_t buffer[2];
+    volatile TaskHandle_t waiting_task;     //task in attesa della trama, notificato dall'ISR alla ricezione dell'ultimo bit
+};
+
+static struct dht_sensor _dht_sensors[DHT_MAX_SENSORS];
+static int _dht_sensors_count = 0;
+static bool _dht_isr_service_installed = false;
 static const char *_dht_tag = "DHT_LIB: ";
 
 /*funzione che azzera il buffer di ricezione*/
 
-static void _dht_clean_buffer(void)
+static void _dht_clean_buffer(struct dht_sensor *sensor)
 {
-    _dht_buffer[0] = 0;
-    _dht_buffer[1] = 0;
+    sensor->buffer[0] = 0;
+    sensor->buffer[1] = 0;
 }
 
-/*routine ISR che riceve i bit sul canale seriale e posiziona gli 1 all'interno del buffer di ricezione, 
-poichè il buffer viene azzerato prima di ogni misurazione non è necessario scrivere gli 0*/
+/*routine ISR che riceve i bit sul canale seriale e posiziona gli 1 all'interno del buffer di ricezione,
+poichè il buffer viene azzerato prima di ogni misurazione non è necessario scrivere gli 0.
+alla ricezione del quarantesimo bit la trama è completa e il task in attesa viene notificato*/
 
 static void IRAM_ATTR _dht_isr_handler(void *arg)
 {
+    struct dht_sensor *sensor = (struct dht_sensor *)arg;
     uint32_t current_time = (uint32_t)esp_timer_get_time();
-    uint32_t interval = current_time - _dht_prev_interrupt_time; //misurazione del'intervallo temporale tra 2 falling cfr datasheet DHT
-    _dht_prev_interrupt_time = current_time;
-    if (interval >= _DHT_ZERO_BIT_MIN_INTERVAL_RANGE && interval <= _DHT_ZERO_BIT_MAX_INTERVAL_RANGE) //ricevuto 0
-    {
-        --_dht_serial_bit_number;
+    uint32_t interval = current_time - sensor->prev_interrupt_time; //misurazione del'intervallo temporale tra 2 falling cfr datasheet DHT
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    sensor->prev_interrupt_time = current_time;
+    if (sensor->serial_bit_number <= 23)   //trama già completa, eventuali fronti successivi vengono ignorati
         return;
-    }
+
+    if (interval >= _DHT_ZERO_BIT_MIN_INTERVAL_RANGE && interval <= _DHT_ZERO_BIT_MAX_INTERVAL_RANGE) //ricevuto 0
+        --sensor->serial_bit_number;
     else if (interval >= _DHT_ONE_BIT_MIN_INTERVAL_RANGE && interval <= _DHT_ONE_BIT_MAX_INTERVAL_RANGE) //ricevuto 1
     {
-        _dht_buffer[_dht_serial_bit_number >> 5] |= 1 << (_dht_serial_bit_number & 31); //equivale a /32 e %32
-        --_dht_serial_bit_number;
-        return;
+        sensor->buffer[sensor->serial_bit_number >> 5] |= 1 << (sensor->serial_bit_number & 31); //equivale a /32 e %32
+        --sensor->serial_bit_number;
     }
     else
         return;
+
+    if (sensor->serial_bit_number == 23 && sensor->waiting_task)
+    {
+        vTaskNotifyGiveFromISR(sensor->waiting_task, &higher_priority_task_woken);
+        if (higher_priority_task_woken == pdTRUE)
+            portYIELD_FROM_ISR();
+    }
 }
 
-/*configurazione del dht, un solo dht alla volta può essere configurato e utilizzato*/
+/*configurazione di un sensore dht, ritorna in handle il riferimento da usare per le misurazioni.
+possono essere configurati fino a DHT_MAX_SENSORS sensori su gpio diversi*/
 
-esp_err_t dht_config(const dht_config_t *dht_cfg)
+esp_err_t dht_config(const dht_config_t *dht_cfg, dht_handle_t *handle)
 {
-    if (!dht_cfg)
+    struct dht_sensor *sensor;
+
+    if (!dht_cfg || !handle)
         return ESP_ERR_INVALID_ARG;
 
-    if (GPIO_IS_VALID_GPIO(dht_cfg->dht_gpio) && !RTC_GPIO_IS_VALID_GPIO(dht_cfg->dht_gpio))
+    if (_dht_sensors_count == DHT_MAX_SENSORS)
     {
-        _dht_gpio_configured = dht_cfg->dht_gpio;
-        gpio_config_t io_conf;
-        io_conf.intr_type = GPIO_INTR_DISABLE;
-        io_conf.mode = GPIO_MODE_OUTPUT;
-        io_conf.pin_bit_mask = BIT(_dht_gpio_configured);
-        io_conf.pull_down_en = 0;
-        io_conf.pull_up_en = 0;
-        gpio_config(&io_conf);
-        gpio_set_level(_dht_gpio_configured, 1);
-        gpio_install_isr_service(0);
+        ESP_LOGE(_dht_tag, "Too many DHT sensors, max %d", DHT_MAX_SENSORS);
+        return ESP_ERR_NO_MEM;
     }
-    else
+
+    if (!GPIO_IS_VALID_GPIO(dht_cfg->dht_gpio) || RTC_GPIO_IS_VALID_GPIO(dht_cfg->dht_gpio))
     {
         ESP_LOGE(_dht_tag, "Invalid DHT GPIO: %d", dht_cfg->dht_gpio);
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (dht_cfg->safe_mode == false)
-        _dht_safe_mode_configured = false;
-    else
-        _dht_safe_mode_configured = true;
+    for (int i = 0; i < _dht_sensors_count; ++i)
+    {
+        if (_dht_sensors[i].gpio == dht_cfg->dht_gpio)
+        {
+            ESP_LOGE(_dht_tag, "DHT GPIO already in use: %d", dht_cfg->dht_gpio);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    sensor = &_dht_sensors[_dht_sensors_count];
 
     if (dht_cfg->dht_type == DHT_11)
     {
-        _dht_sensor_type_configured = DHT_11;
-        _dht_safe_delay_ms_configured = _DHT_11_SAFE_DELAY;
-        _dht_wakeup_pulldown_time_ms_configured = _DHT_11_WAKEUP_PULLDOWN_TIME_MS;
+        sensor->type = DHT_11;
+        sensor->safe_delay_us = _DHT_11_SAFE_DELAY_US;
+        sensor->wakeup_pulldown_time_ms = _DHT_11_WAKEUP_PULLDOWN_TIME_MS;
+        sensor->wakeup_max_pulldown_us = _DHT_11_WAKEUP_MAX_PULLDOWN_US;
     }
     else if (dht_cfg->dht_type == DHT_22)
     {
-        _dht_sensor_type_configured = DHT_22;
-        _dht_safe_delay_ms_configured = _DHT_22_SAFE_DELAY;
-        _dht_wakeup_pulldown_time_ms_configured = _DHT_22_WAKEUP_PULLDOWN_TIME_MS;
+        sensor->type = DHT_22;
+        sensor->safe_delay_us = _DHT_22_SAFE_DELAY_US;
+        sensor->wakeup_pulldown_time_ms = _DHT_22_WAKEUP_PULLDOWN_TIME_MS;
+        sensor->wakeup_max_pulldown_us = _DHT_22_WAKEUP_MAX_PULLDOWN_US;
     }
     else
     {
@@ -96,66 +123,186 @@ esp_err_t dht_config(const dht_config_t *dht_cfg)
         return ESP_ERR_INVALID_ARG;
     }
 
-    _dht_configuration_done = true;
+    sensor->gpio = dht_cfg->dht_gpio;
+    sensor->safe_mode = dht_cfg->safe_mode;
+    sensor->measured = false;
+    sensor->waiting_task = NULL;
+
+    gpio_config_t io_conf;
+    io_conf.intr_type = GPIO_INTR_DISABLE;
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    io_conf.pin_bit_mask = BIT(sensor->gpio);
+    io_conf.pull_down_en = 0;
+    io_conf.pull_up_en = 0;
+    gpio_config(&io_conf);
+    gpio_set_level(sensor->gpio, 1);
+
+    if (!_dht_isr_service_installed)
+    {
+        gpio_install_isr_service(0);
+        _dht_isr_service_installed = true;
+    }
+
+    ++_dht_sensors_count;
+    *handle = sensor;
     return ESP_OK;
 }
 
-/*funzione di misurazione*/
+/*tempo residuo in ms prima che il sensore possa essere interrogato di nuovo, 0 se è già pronto.
+in modalità sicura l'intervallo minimo tra due misurazioni è tracciato come istante dell'ultima misurazione*/
 
-bool dht_measure(double *temp, double *humi)
+uint32_t dht_ready_delay_ms(dht_handle_t handle)
 {
-    if (!_dht_configuration_done)
-    {
-        ESP_LOGE(_dht_tag, "dht configuration missing");
-        return false;
-    }
+    int64_t elapsed;
+
+    if (!handle->safe_mode || !handle->measured)
+        return 0;
+
+    elapsed = esp_timer_get_time() - handle->last_measure_time;
+    if (elapsed >= handle->safe_delay_us)
+        return 0;
+
+    return (uint32_t)((handle->safe_delay_us - elapsed + 999) / 1000);
+}
+
+/*linea dati bassa per svegliare il sensore*/
+
+static void _dht_wakeup(struct dht_sensor *sensor)
+{
+    _dht_clean_buffer(sensor);
+    sensor->serial_bit_number = 63;        //contatore bit in arrivo inizializzato a 63, ultimo bit dell'ultimo byte del buffer di 64 bit
+    sensor->waiting_task = xTaskGetCurrentTaskHandle();
+    gpio_set_level(sensor->gpio, 0);
+    sensor->wakeup_time = esp_timer_get_time();
+}
+
+/*linea dati di nuovo alta, condizione di sleep del sensore, la finestra di sicurezza riparte da ora*/
 
-    char *buffer_byte_pointer = (char *)_dht_buffer;
-
-    if (_dht_safe_mode_configured)
-        vTaskDelay(_dht_safe_delay_ms_configured);
-
-    _dht_clean_buffer();
-    gpio_set_level(_dht_gpio_configured, 0);        //linea dati bassa per svegliare il sensore
-    vTaskDelay(_dht_wakeup_pulldown_time_ms_configured);
-    _dht_serial_bit_number = 63;        //contatore bit in arrivo inizializzato a 63, ultimo bit dell'ultimo byte del buffer di 64 bit
-    gpio_set_direction(_dht_gpio_configured, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(_dht_gpio_configured, GPIO_PULLUP_ONLY);     // pull up e attesa di risposta sulla linea dati
-    gpio_set_intr_type(_dht_gpio_configured, GPIO_INTR_NEGEDGE);    //interrupt falling su linea dati
-    gpio_isr_handler_add(_dht_gpio_configured, _dht_isr_handler, (void *)1);    //attach della funzione di interrupt sulla linea dati
-    _dht_prev_interrupt_time = (uint32_t)esp_timer_get_time();  //campionamento tempo attuale
-    vTaskDelay(10 / portTICK_PERIOD_MS);    //delay minimo, al termine del delay la trasmissione è sicuramente conclusa
-    gpio_isr_handler_remove(_dht_gpio_configured);  //detach della funzione di interrupt
-    gpio_set_direction(_dht_gpio_configured, GPIO_MODE_OUTPUT); //ripristino della condizione di sleep per il sensore dht
-    gpio_set_level(_dht_gpio_configured, 1);
-    
-    //calcolo della checksum, 
-    //se la checksum è corretta vengono aggiornate le variabili di umidità e temperatura e ritorna true
-    //altrimenti ritorna false
-
-    if (_dht_serial_bit_number == 23 && ((*(buffer_byte_pointer + 3)) == (uint8_t)((*(buffer_byte_pointer + 4)) + (*(buffer_byte_pointer + 5)) + (*(buffer_byte_pointer + 6)) + (*(buffer_byte_pointer + 7)))))
+static void _dht_release(struct dht_sensor *sensor)
+{
+    sensor->waiting_task = NULL;
+    gpio_set_direction(sensor->gpio, GPIO_MODE_OUTPUT);
+    gpio_set_level(sensor->gpio, 1);
+    sensor->last_measure_time = esp_timer_get_time();
+    sensor->measured = true;
+}
+
+/*rilascio della linea dati e ricezione della trama, attesa della notifica dell'ISR o del timeout in caso di errore*/
+
+static void _dht_receive(struct dht_sensor *sensor)
+{
+    gpio_set_direction(sensor->gpio, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(sensor->gpio, GPIO_PULLUP_ONLY);     // pull up e attesa di risposta sulla linea dati
+    gpio_set_intr_type(sensor->gpio, GPIO_INTR_NEGEDGE);    //interrupt falling su linea dati
+    gpio_isr_handler_add(sensor->gpio, _dht_isr_handler, (void *)sensor);    //attach della funzione di interrupt sulla linea dati
+    sensor->prev_interrupt_time = (uint32_t)esp_timer_get_time();  //campionamento tempo attuale
+    ulTaskNotifyTake(pdTRUE, (_DHT_FRAME_TIMEOUT_MS + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);    //attesa della trama completa, notificata dall'ISR
+    gpio_isr_handler_remove(sensor->gpio);  //detach della funzione di interrupt
+    sensor->waiting_task = NULL;
+    ulTaskNotifyTake(pdTRUE, 0);    //notifica arrivata dopo il timeout, non deve chiudere la ricezione del sensore successivo
+    _dht_release(sensor);   //ripristino della condizione di sleep per il sensore dht
+}
+
+//calcolo della checksum,
+//se la checksum è corretta vengono aggiornate le variabili di umidità e temperatura e ritorna true
+//altrimenti ritorna false
+
+static bool _dht_decode(struct dht_sensor *sensor, int16_t *temp, int16_t *humi)
+{
+    char *buffer_byte_pointer = (char *)sensor->buffer;
+
+    if (sensor->serial_bit_number == 23 && ((*(buffer_byte_pointer + 3)) == (uint8_t)((*(buffer_byte_pointer + 4)) + (*(buffer_byte_pointer + 5)) + (*(buffer_byte_pointer + 6)) + (*(buffer_byte_pointer + 7)))))
     {
-        if (_dht_sensor_type_configured == DHT_11)
+        if (sensor->type == DHT_11)
         {
             if (humi)
-                *humi = *(buffer_byte_pointer + 7) + ((double)(*(buffer_byte_pointer + 6))) / 10.0;
+                *humi = *(buffer_byte_pointer + 7) * 10 + *(buffer_byte_pointer + 6);
             if (temp)
-                *temp = *(buffer_byte_pointer + 5) + ((double)(*(buffer_byte_pointer + 4))) / 10.0;
+                *temp = *(buffer_byte_pointer + 5) * 10 + *(buffer_byte_pointer + 4);
         }
 
-        else if (_dht_sensor_type_configured == DHT_22)
+        else if (sensor->type == DHT_22)     //il dht22 trasmette già in decimi, la temperatura in modulo e segno
         {
             if (humi)
-                *humi = (double)(*((int16_t *)(buffer_byte_pointer + 6))) / 10.0;
+                *humi = *((int16_t *)(buffer_byte_pointer + 6));
             if (temp) {
                 bool neg = (bool)((*(buffer_byte_pointer + 5)) & BIT7);
                 *(buffer_byte_pointer + 5) &= ~BIT7;
-                *temp = neg ? -((double)(*((int16_t *)(buffer_byte_pointer + 4))) / 10.0) : (double)(*((int16_t *)(buffer_byte_pointer + 4))) / 10.0;             
+                *temp = neg ? -*((int16_t *)(buffer_byte_pointer + 4)) : *((int16_t *)(buffer_byte_pointer + 4));
             }
-                
+
         }
         return true;
     }
     else
         return false;
+}
+
+/*misurazione di un gruppo di sensori, ritorna il numero di misurazioni riuscite.
+ogni sensore riceve il proprio segnale di start subito prima della lettura: con le linee abbassate insieme il segnale
+dei sensori successivi durerebbe anche le trame precedenti e i timeout dei sensori guasti, oltre il limite del dht22.
+un segnale di start prolungato oltre il massimo del sensore, ad es. per il task sospeso da uno a priorità maggiore,
+fa fallire la misurazione senza attendere la trama. la finestra di sicurezza è quella del sensore meno pronto*/
+
+int dht_measure_group(const dht_handle_t *handles, int count, dht_reading_t *readings)
+{
+    uint32_t ready_delay_ms = 0;
+    int measured = 0;
+
+    if (!handles || !readings || count <= 0)
+        return 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (dht_ready_delay_ms(handles[i]) > ready_delay_ms)
+            ready_delay_ms = dht_ready_delay_ms(handles[i]);
+    }
+
+    if (ready_delay_ms)     //attesa solo del tempo residuo della finestra di sicurezza
+        vTaskDelay((ready_delay_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+
+    ulTaskNotifyTake(pdTRUE, 0);    //eventuale notifica residua di una misurazione precedente
+
+    for (int i = 0; i < count; ++i)
+    {
+        _dht_wakeup(handles[i]);
+        vTaskDelay(handles[i]->wakeup_pulldown_time_ms);
+
+        if (esp_timer_get_time() - handles[i]->wakeup_time > handles[i]->wakeup_max_pulldown_us)
+        {
+            _dht_release(handles[i]);
+            ESP_LOGW(_dht_tag, "DHT GPIO %d: start signal too long", handles[i]->gpio);
+            readings[i].ok = false;
+            continue;
+        }
+
+        _dht_receive(handles[i]);
+        readings[i].ok = _dht_decode(handles[i], &readings[i].temp, &readings[i].humi);
+        if (readings[i].ok)
+            ++measured;
+    }
+
+    return measured;
+}
+
+/*funzione di misurazione di un singolo sensore, temperatura e umidità vengono restituite in decimi di grado e di punto percentuale*/
+
+bool dht_measure(dht_handle_t handle, int16_t *temp, int16_t *humi)
+{
+    dht_reading_t reading;
+
+    if (!handle)
+    {
+        ESP_LOGE(_dht_tag, "dht configuration missing");
+        return false;
+    }
+
+    if (!dht_measure_group(&handle, 1, &reading))
+        return false;
+
+    if (temp)
+        *temp = reading.temp;
+    if (humi)
+        *humi = reading.humi;
+    return true;
 }
\ No newline at end of file
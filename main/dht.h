@@ -1,10 +1,14 @@
 #ifndef _DHT_H
 #define _DHT_H
 
-#define _DHT_11_SAFE_DELAY 1500 / portTICK_PERIOD_MS
-#define _DHT_22_SAFE_DELAY 2500 / portTICK_PERIOD_MS
+#define _DHT_11_SAFE_DELAY_US 1500000
+#define _DHT_22_SAFE_DELAY_US 2500000
 #define _DHT_11_WAKEUP_PULLDOWN_TIME_MS 20 / portTICK_PERIOD_MS
 #define _DHT_22_WAKEUP_PULLDOWN_TIME_MS 10 / portTICK_PERIOD_MS
+#define _DHT_11_WAKEUP_MAX_PULLDOWN_US 30000    //durata massima del segnale di start, oltre il sensore può non rispondere
+#define _DHT_22_WAKEUP_MAX_PULLDOWN_US 20000
+
+#define _DHT_FRAME_TIMEOUT_MS 20    //la trama completa dura circa 5 ms, il timeout scatta solo in caso di errore
 
 #define _DHT_RSP_BIT_MIN_INTERVAL_RANGE 0
 #define _DHT_RSP_BIT_MAX_INTERVAL_RANGE 40
@@ -17,6 +21,8 @@
 
 #include "driver/gpio.h"
 
+#include "sensorreading.h"
+
 typedef enum {DHT_11 = 1, DHT_22} dht_sensor_type;
 
 typedef struct {
@@ -25,7 +31,11 @@ typedef struct {
     bool safe_mode;
 } dht_config_t;
 
-esp_err_t dht_config(const dht_config_t *);
-bool dht_measure(double *temp, double *humi);
+typedef struct dht_sensor *dht_handle_t;
+
+esp_err_t dht_config(const dht_config_t *, dht_handle_t *handle);
+bool dht_measure(dht_handle_t handle, int16_t *temp, int16_t *humi);     //temperatura e umidità in decimi
+int dht_measure_group(const dht_handle_t *handles, int count, dht_reading_t *readings);
+uint32_t dht_ready_delay_ms(dht_handle_t handle);
 
 #endif
\ No newline at end of file
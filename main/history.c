@@ -0,0 +1,232 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "history.h"
+
+/*ogni risoluzione è un buffer circolare indicizzato dal numero di periodo (minuti dall'epoch / durata del periodo):
+  lo slot di un periodo è numero % dimensione, gli slot dei periodi saltati vengono svuotati all'avanzare del tempo.
+  ogni campione aggiorna in O(1) lo slot corrente di tutte le risoluzioni*/
+
+#define _HISTORY_LEVELS 3
+#define _HISTORY_EMPTY_SAMPLE INT16_MIN
+
+typedef struct
+{
+    int16_t temp;
+    int16_t humi;
+} _history_sample_t;
+
+typedef struct
+{
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t humi_min;
+    int16_t humi_max;
+    int32_t temp_sum;
+    int32_t humi_sum;
+    uint16_t count;     //campioni aggregati, 0 per periodo senza misure
+} _history_rollup_t;
+
+static _history_sample_t _history_minutes[HISTORY_MINUTE_SLOTS];
+static _history_rollup_t _history_quarter_hours[HISTORY_QUARTER_HOUR_SLOTS];
+static _history_rollup_t _history_hours[HISTORY_HOUR_SLOTS];
+
+static _history_rollup_t *const _history_rollups[_HISTORY_LEVELS] = {NULL, _history_quarter_hours, _history_hours};
+static const uint16_t _history_period_minutes[_HISTORY_LEVELS] = {1, 15, 60};
+static const uint16_t _history_size[_HISTORY_LEVELS] = {HISTORY_MINUTE_SLOTS, HISTORY_QUARTER_HOUR_SLOTS, HISTORY_HOUR_SLOTS};
+
+static uint32_t _history_last_bucket[_HISTORY_LEVELS];      //periodo più recente di ogni risoluzione
+static bool _history_started = false;                       //nessun campione ancora registrato
+
+static void _history_clear_slot(int level, uint32_t index)
+{
+    if (level == HISTORY_MINUTE)
+    {
+        _history_minutes[index].temp = _HISTORY_EMPTY_SAMPLE;
+        _history_minutes[index].humi = _HISTORY_EMPTY_SAMPLE;
+    }
+    else
+        _history_rollups[level][index].count = 0;
+}
+
+/*porta la risoluzione al periodo indicato svuotando gli slot dei periodi saltati, al più un giro completo del buffer*/
+
+static void _history_advance(int level, uint32_t bucket)
+{
+    uint32_t last = _history_last_bucket[level];
+    uint32_t steps;
+
+    if (bucket <= last)
+        return;
+
+    steps = bucket - last;
+    if (steps > _history_size[level])
+        steps = _history_size[level];
+
+    for (uint32_t i = 1; i <= steps; ++i)
+        _history_clear_slot(level, (last + i) % _history_size[level]);
+
+    _history_last_bucket[level] = bucket;
+}
+
+static bool _history_in_window(int level, uint32_t bucket)
+{
+    return _history_started && bucket <= _history_last_bucket[level] && _history_last_bucket[level] - bucket < _history_size[level];
+}
+
+static void _history_rollup_add(_history_rollup_t *rollup, int16_t temp, int16_t humi)
+{
+    if (rollup->count == 0)
+    {
+        rollup->temp_min = rollup->temp_max = temp;
+        rollup->humi_min = rollup->humi_max = humi;
+        rollup->temp_sum = 0;
+        rollup->humi_sum = 0;
+    }
+
+    if (temp < rollup->temp_min)
+        rollup->temp_min = temp;
+    if (temp > rollup->temp_max)
+        rollup->temp_max = temp;
+    if (humi < rollup->humi_min)
+        rollup->humi_min = humi;
+    if (humi > rollup->humi_max)
+        rollup->humi_max = humi;
+
+    rollup->temp_sum += temp;
+    rollup->humi_sum += humi;
+    ++rollup->count;
+}
+
+/*media arrotondata al decimo più vicino*/
+
+static int16_t _history_average(int32_t sum, uint16_t count)
+{
+    return (int16_t)(sum >= 0 ? (sum + count / 2) / count : (sum - count / 2) / count);
+}
+
+/*svuota lo storico, da chiamare prima della creazione dei task*/
+
+void history_init(void)
+{
+    for (int level = 0; level < _HISTORY_LEVELS; ++level)
+    {
+        for (uint32_t i = 0; i < _history_size[level]; ++i)
+            _history_clear_slot(level, i);
+    }
+
+    _history_started = false;
+}
+
+/*registra un campione all'istante now in tutte le risoluzioni*/
+
+void history_add(time_t now, int16_t temp, int16_t humi)
+{
+    uint32_t minute;
+    uint32_t bucket;
+    uint32_t index;
+
+    if (now < HISTORY_MIN_VALID_TIME)
+        return;
+
+    minute = (uint32_t)(now / 60);
+
+    taskENTER_CRITICAL();
+
+    if (!_history_started)
+    {
+        for (int level = 0; level < _HISTORY_LEVELS; ++level)
+            _history_last_bucket[level] = minute / _history_period_minutes[level];
+        _history_started = true;
+    }
+
+    for (int level = 0; level < _HISTORY_LEVELS; ++level)
+    {
+        bucket = minute / _history_period_minutes[level];
+        _history_advance(level, bucket);
+
+        if (!_history_in_window(level, bucket))     //orologio corretto all'indietro oltre la finestra
+            continue;
+
+        index = bucket % _history_size[level];
+        if (level == HISTORY_MINUTE)
+        {
+            _history_minutes[index].temp = temp;
+            _history_minutes[index].humi = humi;
+        }
+        else
+            _history_rollup_add(&_history_rollups[level][index], temp, humi);
+    }
+
+    taskEXIT_CRITICAL();
+}
+
+uint32_t history_period_minutes(history_resolution_t resolution)
+{
+    return _history_period_minutes[resolution];
+}
+
+uint32_t history_capacity(history_resolution_t resolution)
+{
+    return _history_size[resolution];
+}
+
+/*periodo più recente della risoluzione, false se lo storico è vuoto*/
+
+bool history_last_bucket(history_resolution_t resolution, uint32_t *bucket)
+{
+    bool started;
+
+    taskENTER_CRITICAL();
+    started = _history_started;
+    *bucket = _history_last_bucket[resolution];
+    taskEXIT_CRITICAL();
+
+    return started;
+}
+
+/*valori del periodo indicato (minuti dall'epoch / durata del periodo), false se il periodo è fuori dalla finestra o senza misure.
+  per la risoluzione al minuto minimo, massimo e media coincidono con il campione*/
+
+bool history_get(history_resolution_t resolution, uint32_t bucket, history_point_t *point)
+{
+    bool found = false;
+    uint32_t index;
+
+    taskENTER_CRITICAL();
+
+    if (_history_in_window(resolution, bucket))
+    {
+        index = bucket % _history_size[resolution];
+
+        if (resolution == HISTORY_MINUTE)
+        {
+            const _history_sample_t *sample = &_history_minutes[index];
+
+            if (sample->temp != _HISTORY_EMPTY_SAMPLE)
+            {
+                point->temp_avg = point->temp_min = point->temp_max = sample->temp;
+                point->humi_avg = point->humi_min = point->humi_max = sample->humi;
+                found = true;
+            }
+        }
+        else
+        {
+            const _history_rollup_t *rollup = &_history_rollups[resolution][index];
+
+            if (rollup->count)
+            {
+                point->temp_avg = _history_average(rollup->temp_sum, rollup->count);
+                point->temp_min = rollup->temp_min;
+                point->temp_max = rollup->temp_max;
+                point->humi_avg = _history_average(rollup->humi_sum, rollup->count);
+                point->humi_min = rollup->humi_min;
+                point->humi_max = rollup->humi_max;
+                found = true;
+            }
+        }
+    }
+
+    taskEXIT_CRITICAL();
+    return found;
+}
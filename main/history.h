@@ -0,0 +1,41 @@
+#ifndef _HISTORY_H
+#define _HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*storico in RAM di temperatura e umidità a memoria fissa: campioni al minuto per le ultime ore e
+  minimo / massimo / media per quarto d'ora e per ora per i giorni precedenti. valori in decimi*/
+
+#define HISTORY_MINUTE_SLOTS 240        //4 ore
+#define HISTORY_QUARTER_HOUR_SLOTS 96   //1 giorno
+#define HISTORY_HOUR_SLOTS 168          //7 giorni
+
+#define HISTORY_MIN_VALID_TIME 1577836800   //01/01/2020, prima della sincronizzazione sntp i campioni non vengono registrati
+
+typedef enum
+{
+    HISTORY_MINUTE,
+    HISTORY_QUARTER_HOUR,
+    HISTORY_HOUR
+} history_resolution_t;
+
+typedef struct
+{
+    int16_t temp_avg;
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t humi_avg;
+    int16_t humi_min;
+    int16_t humi_max;
+} history_point_t;
+
+void history_init(void);
+void history_add(time_t now, int16_t temp, int16_t humi);
+uint32_t history_period_minutes(history_resolution_t resolution);
+uint32_t history_capacity(history_resolution_t resolution);
+bool history_last_bucket(history_resolution_t resolution, uint32_t *bucket);
+bool history_get(history_resolution_t resolution, uint32_t bucket, history_point_t *point);
+
+#endif
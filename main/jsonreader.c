@@ -0,0 +1,315 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "jsonreader.h"
+
+#define _JSON_NUMBER_HUNDREDTHS_LIMIT 100000000     //i valori oltre questo limite in centesimi saturano
+
+static char *_json_skip_whitespace(char *pos)
+{
+    while (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')
+        ++pos;
+    return pos;
+}
+
+/*converte una cifra esadecimale, ritorna -1 se il carattere non è valido*/
+
+static int _json_hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool _json_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/*legge un numero json in decimi senza virgola mobile, arrotondando sul centesimo. i valori fuori scala saturano
+  al limite, sufficiente per tutti i campi numerici dei comandi. ritorna NULL se il numero non è valido*/
+
+static char *_json_parse_tenths(char *pos, int32_t *tenths)
+{
+    bool negative = false;
+    int32_t hundredths = 0;
+    int exponent = 0;
+    int exponent_sign = 1;
+    int fraction_digits = 0;
+
+    if (*pos == '-')
+    {
+        negative = true;
+        ++pos;
+    }
+
+    if (!_json_is_digit(*pos))
+        return NULL;
+
+    while (_json_is_digit(*pos))
+    {
+        if (hundredths < _JSON_NUMBER_HUNDREDTHS_LIMIT)
+            hundredths = hundredths * 10 + (*pos - '0');
+        ++pos;
+    }
+    hundredths = (hundredths < _JSON_NUMBER_HUNDREDTHS_LIMIT / 100) ? hundredths * 100 : _JSON_NUMBER_HUNDREDTHS_LIMIT;
+
+    if (*pos == '.')
+    {
+        ++pos;
+        if (!_json_is_digit(*pos))
+            return NULL;
+
+        for (; _json_is_digit(*pos); ++pos, ++fraction_digits)     //oltre i centesimi le cifre non contano
+        {
+            if (fraction_digits == 0)
+                hundredths += (*pos - '0') * 10;
+            else if (fraction_digits == 1)
+                hundredths += *pos - '0';
+        }
+    }
+
+    if (*pos == 'e' || *pos == 'E')
+    {
+        ++pos;
+        if (*pos == '+' || *pos == '-')
+            exponent_sign = (*pos++ == '-') ? -1 : 1;
+        if (!_json_is_digit(*pos))
+            return NULL;
+
+        for (; _json_is_digit(*pos); ++pos)
+            if (exponent < 100)
+                exponent = exponent * 10 + (*pos - '0');
+
+        for (; exponent > 0 && hundredths != 0; --exponent)
+        {
+            if (exponent_sign < 0)
+                hundredths /= 10;
+            else
+                hundredths = (hundredths < _JSON_NUMBER_HUNDREDTHS_LIMIT / 10) ? hundredths * 10 : _JSON_NUMBER_HUNDREDTHS_LIMIT;
+        }
+    }
+
+    if (hundredths > _JSON_NUMBER_HUNDREDTHS_LIMIT)
+        hundredths = _JSON_NUMBER_HUNDREDTHS_LIMIT;
+
+    *tenths = (hundredths + 5) / 10;
+    if (negative)
+        *tenths = -*tenths;
+    return pos;
+}
+
+/*decodifica sul posto la stringa che inizia dopo le virgolette in *pos, la termina con '\0' e sposta *pos dopo le virgolette di chiusura.
+  le sequenze \uXXXX diventano utf-8, che non occupa mai più dei 6 caratteri della sequenza. ritorna NULL se la stringa non è valida*/
+
+static char *_json_parse_string(char **pos)
+{
+    char *read = *pos;
+    char *write = *pos;
+    char *start = *pos;
+
+    while (*read != '"')
+    {
+        if (*read == '\0' || (unsigned char)*read < 0x20)
+            return NULL;
+
+        if (*read != '\\')
+        {
+            *write++ = *read++;
+            continue;
+        }
+
+        ++read;
+        switch (*read++)
+        {
+        case '"': *write++ = '"'; break;
+        case '\\': *write++ = '\\'; break;
+        case '/': *write++ = '/'; break;
+        case 'b': *write++ = '\b'; break;
+        case 'f': *write++ = '\f'; break;
+        case 'n': *write++ = '\n'; break;
+        case 'r': *write++ = '\r'; break;
+        case 't': *write++ = '\t'; break;
+        case 'u':
+        {
+            int code = 0;
+
+            for (int i = 0; i < 4; i++)
+            {
+                int digit = _json_hex_digit(*read++);
+                if (digit < 0)
+                    return NULL;
+                code = (code << 4) | digit;
+            }
+
+            if (code < 0x80)
+                *write++ = code;
+            else if (code < 0x800)
+            {
+                *write++ = 0xC0 | (code >> 6);
+                *write++ = 0x80 | (code & 0x3F);
+            }
+            else
+            {
+                *write++ = 0xE0 | (code >> 12);
+                *write++ = 0x80 | ((code >> 6) & 0x3F);
+                *write++ = 0x80 | (code & 0x3F);
+            }
+            break;
+        }
+        default:
+            return NULL;
+        }
+    }
+
+    *pos = read + 1;
+    *write = '\0';
+    return start;
+}
+
+/*salta un oggetto o un array annidato, tenendo conto delle stringhe che possono contenere parentesi.
+  ritorna il puntatore al carattere successivo o NULL se il valore non è chiuso*/
+
+static char *_json_skip_nested(char *pos)
+{
+    int depth = 0;
+
+    do
+    {
+        if (*pos == '\0')
+            return NULL;
+
+        if (*pos == '"')
+        {
+            for (++pos; *pos != '"'; ++pos)
+            {
+                if (*pos == '\0' || (*pos == '\\' && *++pos == '\0'))
+                    return NULL;
+            }
+        }
+        else if (*pos == '{' || *pos == '[')
+            ++depth;
+        else if (*pos == '}' || *pos == ']')
+            --depth;
+
+        ++pos;
+    } while (depth > 0);
+
+    return pos;
+}
+
+/*verifica che in pos ci sia la parola literal e ritorna il puntatore successivo, NULL altrimenti*/
+
+static char *_json_match_literal(char *pos, const char *literal)
+{
+    while (*literal)
+    {
+        if (*pos++ != *literal++)
+            return NULL;
+    }
+    return pos;
+}
+
+/*posiziona il lettore all'interno dell'oggetto json, ritorna false se il messaggio non inizia con un oggetto*/
+
+bool json_reader_init(json_reader_t *reader, char *json)
+{
+    reader->pos = _json_skip_whitespace(json);
+    reader->first = true;
+    reader->error = (*reader->pos != '{');
+
+    if (!reader->error)
+        ++reader->pos;
+
+    return !reader->error;
+}
+
+/*legge il prossimo campo dell'oggetto, ritorna false alla chiusura dell'oggetto o se il messaggio è malformato (reader->error)*/
+
+bool json_reader_next(json_reader_t *reader, json_member_t *member)
+{
+    char *pos;
+
+    if (reader->error)
+        return false;
+
+    pos = _json_skip_whitespace(reader->pos);
+
+    if (*pos == '}')
+    {
+        reader->pos = pos + 1;
+        return false;
+    }
+
+    if (!reader->first)
+    {
+        if (*pos != ',')
+            goto malformed;
+        pos = _json_skip_whitespace(pos + 1);
+    }
+
+    //chiave
+    if (*pos != '"')
+        goto malformed;
+    ++pos;
+    member->key = _json_parse_string(&pos);
+    if (!member->key)
+        goto malformed;
+
+    pos = _json_skip_whitespace(pos);
+    if (*pos != ':')
+        goto malformed;
+    pos = _json_skip_whitespace(pos + 1);
+
+    //valore
+    switch (*pos)
+    {
+    case '"':
+        ++pos;
+        member->type = JSON_VALUE_STRING;
+        member->string = _json_parse_string(&pos);
+        if (!member->string)
+            goto malformed;
+        break;
+    case '{':
+    case '[':
+        member->type = (*pos == '{') ? JSON_VALUE_OBJECT : JSON_VALUE_ARRAY;
+        member->object = pos;
+        pos = _json_skip_nested(pos);
+        if (!pos)
+            goto malformed;
+        break;
+    case 't':
+        member->type = JSON_VALUE_TRUE;
+        pos = _json_match_literal(pos, "true");
+        break;
+    case 'f':
+        member->type = JSON_VALUE_FALSE;
+        pos = _json_match_literal(pos, "false");
+        break;
+    case 'n':
+        member->type = JSON_VALUE_NULL;
+        pos = _json_match_literal(pos, "null");
+        break;
+    default:
+        if (*pos != '-' && (*pos < '0' || *pos > '9'))
+            goto malformed;
+        member->type = JSON_VALUE_NUMBER;
+        pos = _json_parse_tenths(pos, &member->tenths);
+        break;
+    }
+
+    if (!pos)
+        goto malformed;
+
+    reader->pos = pos;
+    reader->first = false;
+    return true;
+
+malformed:
+    reader->error = true;
+    return false;
+}
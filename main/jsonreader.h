@@ -0,0 +1,41 @@
+#ifndef _JSONREADER_H
+#define _JSONREADER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*lettore json in streaming per oggetti, lavora direttamente sul buffer del messaggio senza costruire alberi né allocare memoria:
+  chiavi e stringhe vengono decodificate sul posto e terminate con '\0', il buffer viene quindi modificato.
+  i numeri sono letti in virgola fissa, in decimi*/
+
+typedef enum
+{
+    JSON_VALUE_NULL,
+    JSON_VALUE_TRUE,
+    JSON_VALUE_FALSE,
+    JSON_VALUE_NUMBER,
+    JSON_VALUE_STRING,
+    JSON_VALUE_OBJECT,
+    JSON_VALUE_ARRAY
+} json_value_type_t;
+
+typedef struct
+{
+    char *pos;
+    bool first;     //nessun campo ancora letto, il prossimo non è preceduto dalla virgola
+    bool error;     //messaggio malformato, la lettura si interrompe
+} json_reader_t;
+
+typedef struct
+{
+    const char *key;
+    json_value_type_t type;
+    int32_t tenths;         //valore in decimi arrotondato, valido per JSON_VALUE_NUMBER
+    const char *string;     //valido per JSON_VALUE_STRING
+    char *object;           //inizio dell'oggetto annidato per JSON_VALUE_OBJECT, da leggere con un nuovo json_reader_t
+} json_member_t;
+
+bool json_reader_init(json_reader_t *reader, char *json);
+bool json_reader_next(json_reader_t *reader, json_member_t *member);
+
+#endif
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <string.h>
+#include "jsonwriter.h"
+
+/*accoda len caratteri al buffer lasciando spazio per il terminatore, in caso di spazio insufficiente segnala l'overflow*/
+
+static void _json_writer_append(json_writer_t *writer, const char *str, int len)
+{
+    if (writer->overflow || writer->length + len >= writer->size)
+    {
+        writer->overflow = true;
+        return;
+    }
+
+    memcpy(writer->buffer + writer->length, str, len);
+    writer->length += len;
+}
+
+/*scrive la chiave del campo preceduta dalla virgola se necessario, le chiavi sono costanti e non richiedono escape*/
+
+static void _json_writer_key(json_writer_t *writer, const char *key)
+{
+    if (!writer->empty)
+        _json_writer_append(writer, ",", 1);
+    writer->empty = false;
+
+    _json_writer_append(writer, "\"", 1);
+    _json_writer_append(writer, key, strlen(key));
+    _json_writer_append(writer, "\":", 2);
+}
+
+/*inizializza il writer su un buffer preallocato e apre l'oggetto json*/
+
+void json_writer_init(json_writer_t *writer, char *buffer, const int size)
+{
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->length = 0;
+    writer->empty = true;
+    writer->overflow = false;
+    _json_writer_append(writer, "{", 1);
+}
+
+/*scrive un valore in decimi in virgola fissa, la parte decimale viene omessa se nulla (es. 200 -> 20, -5 -> -0.5)*/
+
+static void _json_writer_tenths(json_writer_t *writer, int32_t tenths)
+{
+    char number[16];
+    uint32_t magnitude = tenths < 0 ? -(uint32_t)tenths : (uint32_t)tenths;
+    int length;
+
+    length = snprintf(number, sizeof(number) - 2, "%s%u", tenths < 0 ? "-" : "", (unsigned)(magnitude / 10));
+    if (magnitude % 10)
+    {
+        number[length++] = '.';
+        number[length++] = '0' + magnitude % 10;
+    }
+
+    _json_writer_append(writer, number, length);
+}
+
+/*separatore tra gli elementi di un array*/
+
+static void _json_writer_element(json_writer_t *writer)
+{
+    if (!writer->empty)
+        _json_writer_append(writer, ",", 1);
+    writer->empty = false;
+}
+
+void json_writer_add_tenths(json_writer_t *writer, const char *key, int32_t tenths)
+{
+    _json_writer_key(writer, key);
+    _json_writer_tenths(writer, tenths);
+}
+
+void json_writer_add_uint(json_writer_t *writer, const char *key, uint32_t value)
+{
+    char number[12];
+
+    _json_writer_key(writer, key);
+    _json_writer_append(writer, number, snprintf(number, sizeof(number), "%u", (unsigned)value));
+}
+
+/*array di valori: apertura con la chiave, elementi aggiunti in sequenza, chiusura obbligatoria prima del campo successivo*/
+
+void json_writer_begin_array(json_writer_t *writer, const char *key)
+{
+    _json_writer_key(writer, key);
+    _json_writer_append(writer, "[", 1);
+    writer->empty = true;
+}
+
+void json_writer_array_add_tenths(json_writer_t *writer, int32_t tenths)
+{
+    _json_writer_element(writer);
+    _json_writer_tenths(writer, tenths);
+}
+
+void json_writer_array_add_uint(json_writer_t *writer, uint32_t value)
+{
+    char number[12];
+
+    _json_writer_element(writer);
+    _json_writer_append(writer, number, snprintf(number, sizeof(number), "%u", (unsigned)value));
+}
+
+void json_writer_array_add_bool(json_writer_t *writer, bool value)
+{
+    _json_writer_element(writer);
+    if (value)
+        _json_writer_append(writer, "true", 4);
+    else
+        _json_writer_append(writer, "false", 5);
+}
+
+void json_writer_array_add_null(json_writer_t *writer)
+{
+    _json_writer_element(writer);
+    _json_writer_append(writer, "null", 4);
+}
+
+void json_writer_end_array(json_writer_t *writer)
+{
+    _json_writer_append(writer, "]", 1);
+    writer->empty = false;
+}
+
+void json_writer_add_bool(json_writer_t *writer, const char *key, bool value)
+{
+    _json_writer_key(writer, key);
+    if (value)
+        _json_writer_append(writer, "true", 4);
+    else
+        _json_writer_append(writer, "false", 5);
+}
+
+/*scrive un campo stringa con escape di virgolette, backslash e caratteri di controllo*/
+
+void json_writer_add_string(json_writer_t *writer, const char *key, const char *value)
+{
+    const char *run = value;
+
+    _json_writer_key(writer, key);
+    _json_writer_append(writer, "\"", 1);
+
+    for (; *value; ++value)
+    {
+        if (*value == '"' || *value == '\\' || (unsigned char)*value < 0x20)
+        {
+            char escaped[7];
+
+            _json_writer_append(writer, run, value - run);      //tratto senza caratteri speciali copiato in blocco
+            if (*value == '"' || *value == '\\')
+                _json_writer_append(writer, escaped, snprintf(escaped, sizeof(escaped), "\\%c", *value));
+            else
+                _json_writer_append(writer, escaped, snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)*value));
+            run = value + 1;
+        }
+    }
+
+    _json_writer_append(writer, run, value - run);
+    _json_writer_append(writer, "\"", 1);
+}
+
+/*chiude l'oggetto json e termina la stringa, ritorna la lunghezza del messaggio o -1 se il buffer non è sufficiente*/
+
+int json_writer_finish(json_writer_t *writer)
+{
+    _json_writer_append(writer, "}", 1);
+
+    if (writer->overflow)
+        return -1;
+
+    writer->buffer[writer->length] = '\0';
+    return writer->length;
+}
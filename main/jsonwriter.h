@@ -0,0 +1,31 @@
+#ifndef _JSONWRITER_H
+#define _JSONWRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*writer json compatto su buffer preallocato, nessuna allocazione dinamica*/
+
+typedef struct
+{
+    char *buffer;
+    int size;
+    int length;
+    bool empty;         //nessun campo o elemento ancora scritto, il prossimo non richiede la virgola
+    bool overflow;      //il buffer non è sufficiente, il messaggio va scartato
+} json_writer_t;
+
+void json_writer_init(json_writer_t *writer, char *buffer, const int size);
+void json_writer_add_tenths(json_writer_t *writer, const char *key, int32_t tenths);
+void json_writer_add_uint(json_writer_t *writer, const char *key, uint32_t value);
+void json_writer_begin_array(json_writer_t *writer, const char *key);
+void json_writer_array_add_tenths(json_writer_t *writer, int32_t tenths);
+void json_writer_array_add_uint(json_writer_t *writer, uint32_t value);
+void json_writer_array_add_bool(json_writer_t *writer, bool value);
+void json_writer_array_add_null(json_writer_t *writer);
+void json_writer_end_array(json_writer_t *writer);
+void json_writer_add_bool(json_writer_t *writer, const char *key, bool value);
+void json_writer_add_string(json_writer_t *writer, const char *key, const char *value);
+int json_writer_finish(json_writer_t *writer);
+
+#endif
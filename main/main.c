@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <string.h>
 #include <time.h>
 
@@ -6,62 +7,55 @@
 #include "freertos/event_groups.h"
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
+#include "freertos/timers.h"
 #include "esp_system.h"
 #include "esp_log.h"
-#include "esp_netif.h"
-#include "esp_event.h"
-#include "esp_wifi.h"
-#include "driver/gpio.h"
-#include "lwip/err.h"
-#include "lwip/sys.h"
-#include "lwip/sockets.h"
-#include "lwip/dns.h"
-#include "lwip/netdb.h"
-#include "mqtt_client.h"
-#include "lwip/apps/sntp.h"
-#include "cJSON.h"
-
-#include "dht.h"
-#include "timeinterval.h"
-
-/*definizione macro per wifi*/
-
-#define EXAMPLE_ESP_WIFI_SSID      "sistembed"
-#define EXAMPLE_ESP_WIFI_PASS      "lastessa"
-#define EXAMPLE_ESP_MAXIMUM_RETRY  CONFIG_ESP_MAXIMUM_RETRY
-
-/*definizione macro per mqtt*/
 
+#include "timeinterval.h"
+#include "jsonwriter.h"
+#include "commandpool.h"
+#include "jsonreader.h"
+#include "thermostate.h"
+#include "sensorfilter.h"
+#include "history.h"
+#include "telemetrylog.h"
+#include "settings.h"
+#include "reconnect.h"
+#include "platform.h"
+#include "thermocontrol.h"
+#include "optimumstart.h"
+#include "thermoloop.h"
+#include "metrics.h"
+
+/*definizione macro per mqtt, l'indirizzo del broker può essere ridefinito dalla configurazione della piattaforma*/
+
+#ifndef CONFIG_BROKER_URL
 #define CONFIG_BROKER_URL   "mqtt://server.test"
+#endif
 #define MQTT_COMMAND_SUBSCRIBE_TOPIC "tamba/test/comandi"
 #define MQTT_DATA_PUBLISH_TOPIC "tamba/test/dati"
+#define MQTT_HISTORY_PUBLISH_TOPIC "tamba/test/storico"
+#define MQTT_EVENTS_PUBLISH_TOPIC "tamba/test/eventi"
+#define MQTT_METRICS_PUBLISH_TOPIC "tamba/test/metriche"
+#define MQTT_PUBLISH_BUFFER_SIZE 2560   //stato completo con programmazione settimanale alla massima lunghezza
 
-/*definizione dei gpio*/
-
-#define LED_BUILTIN GPIO_NUM_2
-#define LED_BUILTIN_MASK GPIO_Pin_2
-
-#define RELAY GPIO_NUM_4
-#define RELAY_MASK GPIO_Pin_4
+/*attesa tra i tentativi di misurazione falliti, raddoppia ad ogni fallimento*/
 
-#define DHT_GPIO GPIO_NUM_5
+#define MEASURE_RETRY_MIN_DELAY_MS 2500
+#define MEASURE_RETRY_MAX_DELAY_MS 60000
 
-/*definizione estremi per valori di temperatura in gradi centigradi*/
+/*fino alla sincronizzazione sntp il termostato funziona in modalità sicura, l'orario viene ricontrollato con questo periodo*/
 
-#define MIN_TARGET_TEMP 15
-#define MAX_TARGET_TEMP 30
+#define TIME_SYNC_POLL_MS 1000
 
-#define MIN_BASE_TEMP 5
-#define MAX_BASE_TEMP 15
-
-#define MIN_DELTA_TEMP 0
-#define MAX_DELTA_TEMP 1
-
-/*definizione per la programmazione dei giorni della settimana*/
-
-#define TIME_INTERVALS_PER_DAY 10
-#define DAYS_PER_WEEK 7
+/*il task dei comandi, senza modifiche da salvare, controlla con questo periodo se il termostato ha appreso un nuovo
+  campione del modello dell'avvio anticipato, salvato poi come le impostazioni*/
 
+#ifdef CONFIG_THERMO_OPTIMUM_START
+#define OPTIMUM_START_SAVE_POLL_TICKS (60000 / portTICK_PERIOD_MS)
+#else
+#define OPTIMUM_START_SAVE_POLL_TICKS portMAX_DELAY
+#endif
 
 /* definizione dei bits per task di connessione e riconnessione*/
 
@@ -83,37 +77,123 @@
 #define DHT_SENSOR_STATUS_PUBLISHER_TASK BIT8
 #define WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK BIT9
 #define UPDATE_REQUEST_BIT_PUBLISHER_TASK BIT10
+#define CONTROL_MODE_UPDATE_BIT_PUBLISHER_TASK BIT14
+
+#define ALL_BITS_PUBLISHER_TASK (CURRENT_TEMP_HUMI_UPDATE_BIT_PUBLISHER_TASK | TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK | BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK | DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK | MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK | PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK | THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK | NODE_ONLINE_STATUS_BIT_PUBLISHER_TASK | DHT_SENSOR_STATUS_PUBLISHER_TASK | WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | UPDATE_REQUEST_BIT_PUBLISHER_TASK | CONTROL_MODE_UPDATE_BIT_PUBLISHER_TASK)
 
 #define WAKE_UP_BIT_THERMO_TASK BIT11
 
+#define HISTORY_QUERY_BIT_PUBLISHER_TASK BIT12     //escluso da ALL_BITS_PUBLISHER_TASK, lo storico non fa parte dello stato completo
+
+#define OFFLINE_REPLAY_BIT_PUBLISHER_TASK BIT13    //ripubblicazione degli eventi registrati offline, esclusa da ALL_BITS_PUBLISHER_TASK
+
+#define METRICS_BIT_PUBLISHER_TASK BIT15    //snapshot periodico delle metriche su un topic dedicato, escluso da ALL_BITS_PUBLISHER_TASK
+
+#define PERSISTENT_SETTINGS_BITS (TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK | BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK | DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK | MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK | PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK | WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | CONTROL_MODE_UPDATE_BIT_PUBLISHER_TASK)     //comandi che modificano le impostazioni salvate in nvs
+
+#define WAIT_BITS_PUBLISHER_TASK (ALL_BITS_PUBLISHER_TASK | HISTORY_QUERY_BIT_PUBLISHER_TASK | OFFLINE_REPLAY_BIT_PUBLISHER_TASK | METRICS_BIT_PUBLISHER_TASK)
+
+#define HISTORY_CHUNK_POINTS 24     //periodi per messaggio nella pubblicazione dello storico
+#define OFFLINE_REPLAY_BATCH_EVENTS 32  //eventi per messaggio nella ripubblicazione del registro offline
+
 static const char *TAG = "thermo_app";
 
-/* variabili di stato globali deifinizione e inizializzazione*/
+/* stato globale del termostato, valori iniziali. lo stato è condiviso tra i task tramite thermo_state_read / thermo_state_write*/
+
+static const thermo_state_t thermo_state_defaults = {
+    .target_temp = 200,     //temperatura target desiderata inizialittata a 20°C
+    .base_temp = 120,       //temperatura minima sotto la quale il riscaldamento parte comunque, inizializzata a 12°C
+    .delta_temp = 2,        //differenza di temperatura dal target per lo spegnimento del riscaldamento, 0.2°C
+    .current_temp = 0,
+    .current_humi = 0,
+    .main_switch = false,
+    .prog_switch = false,
+    .thermo_on = false,
+    .node_online = false,
+    .dht_ok = false,
+#ifdef CONFIG_THERMO_CONTROL_TPI
+    .control_mode = THERMO_CONTROL_TPI,
+#else
+    .control_mode = THERMO_CONTROL_HYSTERESIS,
+#endif
+};
+
+/*parametri della regolazione a tempo proporzionale*/
+
+static const thermo_tpi_params_t thermo_tpi_params = {
+    .cycle_s = CONFIG_THERMO_TPI_CYCLE_S,
+    .kp = CONFIG_THERMO_TPI_KP,
+    .ki = CONFIG_THERMO_TPI_KI,
+    .min_on_s = CONFIG_THERMO_TPI_MIN_ON_S,
+    .min_off_s = CONFIG_THERMO_TPI_MIN_OFF_S,
+};
+
+const char *control_mode_names[] = {"hysteresis", "tpi"};     //valori di controlMode, indicizzati da thermo_control_mode_t
+
+week_prog_t week_prog;      //programmazione oraria settimanale al minuto con indice dei cambi di stato
+
+/*mutex della programmazione settimanale: modificata dal task dei comandi, letta dal termostato e dal publisher,
+  che aggiorna anche la cache delle stringhe. le sezioni sono brevi ma troppo lunghe per una sezione critica*/
+
+static SemaphoreHandle_t week_prog_mutex;
+
+#define WEEK_PROG_LOCK() xSemaphoreTake(week_prog_mutex, portMAX_DELAY)
+#define WEEK_PROG_UNLOCK() xSemaphoreGive(week_prog_mutex)
+
+static optimum_start_model_t optimum_start_model;      //velocità di riscaldamento appresa, usata solo da thermo_task dopo l'avvio
+
+/*copia dell'ultimo modello appreso passata dal termostato al task dei comandi per il salvataggio, in sezione critica*/
+
+static optimum_start_model_t optimum_start_learned;
+static volatile bool optimum_start_learned_pending = false;
 
-double target_temp = 20;     //temperatura target desiderata inizialittata a 20°C
-double base_temp = 12;       //temperatura minima sotto la quale il riscaldamento parte comunque, inizializzata a 12°C
-double delta_temp = 0.2;    //differenza di temperatura dal target per lo spegnimento del riscaldamento
-double current_temp = 0;    //temperatura corrente rilevata
-double current_humi = 0;    //umidità corrente rilevata
-bool main_switch = false;   //switch generale termostato
-bool prog_switch = false;   //switch attivazione / disattivazoine programmazione oraria
-bool thermo_on = false;     //stato riscaldamento acceso / spento
-bool node_online = false;   //stato connessione wi-fi e mqtt
-bool dht_ok = false;        //stato sensore dht per rilevazione temperatura e umidità
-daytime_interval_sec_t week_prog[DAYS_PER_WEEK][TIME_INTERVALS_PER_DAY];   //programmazione oraria settimanale, matrice di programmazioni giornaliere
+/*buffer statico per la serializzazione dei messaggi mqtt pubblicati*/
+
+static char mqtt_publish_buffer[MQTT_PUBLISH_BUFFER_SIZE];
+
+/*contatori del publisher mqtt*/
+
+uint32_t published_messages = 0;    //messaggi mqtt pubblicati
+uint32_t coalesced_updates = 0;     //aggiornamenti accorpati in un messaggio già esistente, cioè messaggi risparmiati
+uint32_t suppressed_updates = 0;    //aggiornamenti non pubblicati perché il valore coincide con l'ultimo pubblicato
+
+/*latenze di avvio in microsecondi dal boot, 0 finché l'evento non si è verificato*/
+
+int64_t boot_first_measure_us = 0;          //prima misura valida
+int64_t boot_first_relay_decision_us = 0;   //prima decisione sul relè
+int64_t boot_time_sync_us = 0;              //orario valido, fine della modalità sicura
+int64_t boot_first_publish_us = 0;          //primo messaggio di stato pubblicato
+
+static volatile uint32_t command_wake_ms = 0;   //ricezione dell'ultimo comando che ha risvegliato il termostato, in ms dall'avvio, 0 se già valutato
+
+/*richiesta di storico: risoluzione e intervallo in minuti prima del periodo più recente*/
+
+typedef struct
+{
+    history_resolution_t resolution;
+    uint32_t from_minutes;
+    uint32_t to_minutes;
+} history_query_t;
+
+static QueueHandle_t history_query_queue;     //ultima richiesta di storico, una nuova richiesta sostituisce quella non ancora servita
+static history_point_t history_chunk[HISTORY_CHUNK_POINTS];
+static bool history_chunk_valid[HISTORY_CHUNK_POINTS];
+
+static telemetry_event_t offline_replay_batch[OFFLINE_REPLAY_BATCH_EVENTS];
 
 const char *weekday_json_key_names[] = {"sundayProg", "mondayProg", "tuesdayProg", "wednesdayProg", "thursdayProg", "fridayProg", "saturdayProg"};
 
+/*stato dei tentativi di riconnessione e metriche delle disconnessioni, gestiti dal task di riconnessione*/
+
+static reconnect_link_t wifi_link;
+static reconnect_link_t mqtt_link;
+
 /*event groups handlers*/
 
 static EventGroupHandle_t connection_event_group;
 static EventGroupHandle_t reconnection_request_group;
 static EventGroupHandle_t global_variable_update_group;
 
-/*client mqtt*/
-
-esp_mqtt_client_handle_t mqtt_client;
-
 /*task handlers*/
 
 TaskHandle_t led_builtin_blinker_task_handler;
@@ -123,17 +203,15 @@ TaskHandle_t try_to_reconnect_task_handler;
 TaskHandle_t app_time_update_task_handler;
 TaskHandle_t json_decode_global_variables_update_task_handler;
 TaskHandle_t thermo_task_handler;
+TaskHandle_t measure_task_handler;
 
-/*queue handler per mqtt data*/
+/*timer one-shot che risveglia il termostato al prossimo cambio di stato della programmazione*/
 
-QueueHandle_t mqtt_data_pointers_queue_handler;
+TimerHandle_t prog_transition_timer_handler;
+TimerHandle_t metrics_timer_handler;
 
 /*PROTOTIPI DI FUNZIONI LOCALI*/
 
-void wifi_setup(void);
-void sntp_setup(void);
-void gpio_setup(void);
-void dht_setup(void);
 void mqtt_client_setup(void);
 void week_prog_setup(void);
 
@@ -145,9 +223,9 @@ static void led_builtin_blinker_task(void *arg)
 {
     for (;;) 
     {
-        gpio_set_level(LED_BUILTIN, 0);
+        platform_led_set(true);
         vTaskDelay(250 / portTICK_PERIOD_MS);
-        gpio_set_level(LED_BUILTIN, 1);
+        platform_led_set(false);
         vTaskDelay(250 / portTICK_PERIOD_MS);
     }
 
@@ -158,43 +236,57 @@ static void led_builtin_blinker_task(void *arg)
 
 static void connection_event_manager_task(void *arg)
 {   
+    bool wifi_connected = false;
+
     for (;;) 
     {
         EventBits_t bits = xEventGroupWaitBits(connection_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT | MQTT_CONNECTED_BIT | MQTT_FAIL_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
 
         if (bits & WIFI_CONNECTED_BIT) //connessione wi-fi stabilita
         {
-            ESP_LOGI(TAG, "connected to ap SSID:%s password:%s", EXAMPLE_ESP_WIFI_SSID, EXAMPLE_ESP_WIFI_PASS);
-            sntp_init();                            //avvio servizio sntp
-            esp_mqtt_client_start(mqtt_client);     //avvio client mqtt
+            ESP_LOGI(TAG, "wifi connected");
+            wifi_connected = true;
+            xEventGroupSetBits(reconnection_request_group, WIFI_CONNECTED_BIT);    //fine dei tentativi di riconnessione wi-fi
+            platform_time_sync_start();             //avvio sincronizzazione dell'orario
+            platform_mqtt_start();                  //avvio client mqtt
         }
 
-        else if (bits & WIFI_FAIL_BIT) //connessione wi-fi persa o non stabilita
+        else if (bits & WIFI_FAIL_BIT) //connessione wi-fi persa o tentativo di connessione fallito
         {
-            ESP_LOGI(TAG, "Failed to connect to SSID:%s, password:%s", EXAMPLE_ESP_WIFI_SSID, EXAMPLE_ESP_WIFI_PASS);
-            node_online = false;
-            vTaskSuspend(mqtt_publish_json_task_handler);   //sospensione task publisher mqtt
-            esp_mqtt_client_stop(mqtt_client);              //stop client mqtt
-            sntp_stop();                                    //stop servizio sntp
+            ESP_LOGI(TAG, "wifi disconnected or connection failed");
+            if (wifi_connected)     //i servizi di rete vengono fermati solo alla perdita della connessione, non ad ogni tentativo fallito
+            {
+                wifi_connected = false;
+                thermo_state_write_begin()->node_online = false;
+                thermo_state_write_end();
+                telemetry_log_start_recording();                //misure e cambi di stato del relè registrati fino alla riconnessione
+                vTaskSuspend(mqtt_publish_json_task_handler);   //sospensione task publisher mqtt
+                platform_mqtt_stop();                           //stop client mqtt
+                platform_time_sync_stop();                      //stop sincronizzazione dell'orario
+                vTaskResume(led_builtin_blinker_task_handler);  //lampeggio led builtin segnala il problema
+            }
             xEventGroupSetBits(reconnection_request_group, WIFI_FAIL_BIT);  //notifica perdita connessione wi-fi per il task di riconnessione
-            vTaskResume(led_builtin_blinker_task_handler);  //lampeggio led builtin segnala il problema
         }
 
         else if (bits & MQTT_CONNECTED_BIT) //connessione al broker mqtt stabilita
         {
             ESP_LOGI(TAG, "mqtt client connected to broker");
-            node_online = true;
-            esp_mqtt_client_subscribe(mqtt_client, MQTT_COMMAND_SUBSCRIBE_TOPIC, 0); //sottoscrizione del topic pree i comandi
+            thermo_state_write_begin()->node_online = true;
+            thermo_state_write_end();
+            xEventGroupSetBits(reconnection_request_group, MQTT_CONNECTED_BIT);    //fine dei tentativi di riconnessione al broker
+            platform_mqtt_subscribe(MQTT_COMMAND_SUBSCRIBE_TOPIC);  //sottoscrizione del topic pree i comandi
             vTaskResume(mqtt_publish_json_task_handler);    //attivazione del publisher mqtt
             vTaskSuspend(led_builtin_blinker_task_handler); //sospensione lampeggio led builtin 
-            gpio_set_level(LED_BUILTIN, 1); //spegnimento del led builtin attivo basso
-            xEventGroupSetBits(global_variable_update_group, UPDATE_REQUEST_BIT_PUBLISHER_TASK); //set del bit per inviare lo stato globale del sistema tramite mqtt publisher task   
+            platform_led_set(false);    //spegnimento del led builtin
+            xEventGroupSetBits(global_variable_update_group, UPDATE_REQUEST_BIT_PUBLISHER_TASK | OFFLINE_REPLAY_BIT_PUBLISHER_TASK); //set dei bit per inviare gli eventi registrati offline e lo stato globale del sistema tramite mqtt publisher task   
         }
 
         else if (bits & MQTT_FAIL_BIT) //connessione al broker mqtt persa o non stabilita
         {
             ESP_LOGI(TAG, "mqtt client disconnected");
-            node_online = false;
+            thermo_state_write_begin()->node_online = false;
+            thermo_state_write_end();
+            telemetry_log_start_recording();
             vTaskSuspend(mqtt_publish_json_task_handler); //stop client mqtt
             xEventGroupSetBits(reconnection_request_group, MQTT_FAIL_BIT); //notifica perdita connessione broker mqtt per il task di riconnessione
             vTaskResume(led_builtin_blinker_task_handler); //lampeggio led builtin segnala il problema
@@ -210,385 +302,1119 @@ static void connection_event_manager_task(void *arg)
 
 /*
 task che pubblica lo stato del sistema tramite messaggi mqtt in formato json, i task che vogliono pubblicare una informazione settano
-il bit specifico nell'event group global_variable_update_group
+il bit specifico nell'event group global_variable_update_group.
+ad ogni risveglio, dopo la finestra di accorpamento opzionale, tutti i bit pendenti vengono prelevati e pubblicati in un unico messaggio
 */
 
+/*bit dei campi di stato il cui valore coincide con l'ultimo pubblicato*/
+
+static EventBits_t unchanged_state_bits(const thermo_state_t *state, const thermo_state_t *published)
+{
+    EventBits_t bits = 0;
+
+    if(state->target_temp == published->target_temp)
+        bits |= TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK;
+    if(state->base_temp == published->base_temp)
+        bits |= BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK;
+    if(state->delta_temp == published->delta_temp)
+        bits |= DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK;
+    if(state->main_switch == published->main_switch)
+        bits |= MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK;
+    if(state->prog_switch == published->prog_switch)
+        bits |= PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK;
+    if(state->thermo_on == published->thermo_on)
+        bits |= THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK;
+    if(state->dht_ok == published->dht_ok)
+        bits |= DHT_SENSOR_STATUS_PUBLISHER_TASK;
+    if(state->control_mode == published->control_mode)
+        bits |= CONTROL_MODE_UPDATE_BIT_PUBLISHER_TASK;
+
+    return bits;
+}
+
+/*aggiorna i valori dell'ultima pubblicazione per i campi inclusi nel messaggio*/
+
+static void record_published_state(thermo_state_t *published, const thermo_state_t *state, EventBits_t bits)
+{
+    if(bits & TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK)
+        published->target_temp = state->target_temp;
+    if(bits & BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK)
+        published->base_temp = state->base_temp;
+    if(bits & DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK)
+        published->delta_temp = state->delta_temp;
+    if(bits & MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK)
+        published->main_switch = state->main_switch;
+    if(bits & PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK)
+        published->prog_switch = state->prog_switch;
+    if(bits & THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK)
+        published->thermo_on = state->thermo_on;
+    if(bits & DHT_SENSOR_STATUS_PUBLISHER_TASK)
+        published->dht_ok = state->dht_ok;
+    if(bits & CONTROL_MODE_UPDATE_BIT_PUBLISHER_TASK)
+        published->control_mode = state->control_mode;
+}
+
+/*array json di un campo dei periodi del blocco corrente, null per i periodi senza misure*/
+
+static void add_history_array(json_writer_t *writer, const char *key, int count, size_t field)
+{
+    json_writer_begin_array(writer, key);
+    for(int i = 0; i < count; i++)
+    {
+        if(history_chunk_valid[i])
+            json_writer_array_add_tenths(writer, *(const int16_t *)((const char *)&history_chunk[i] + field));
+        else
+            json_writer_array_add_null(writer);
+    }
+    json_writer_end_array(writer);
+}
+
+/*pubblicazione dello storico richiesto in blocchi di HISTORY_CHUNK_POINTS periodi, dal più vecchio al più recente.
+  ogni blocco riporta l'istante di inizio del primo periodo, la durata del periodo in minuti, il proprio indice e il numero di blocchi.
+  se non ci sono periodi nell'intervallo viene pubblicato un solo messaggio con chunks a 0*/
+
+static void publish_history(const history_query_t *query)
+{
+    json_writer_t writer;
+    uint32_t period = history_period_minutes(query->resolution);
+    uint32_t oldest = query->from_minutes / period;
+    uint32_t newest = query->to_minutes / period;
+    uint32_t last;
+    uint32_t first = 0;
+    uint32_t count = 0;
+    uint32_t chunks;
+    uint32_t start;
+    int points;
+    int length;
+
+    if(oldest >= history_capacity(query->resolution))
+        oldest = history_capacity(query->resolution) - 1;
+
+    if(history_last_bucket(query->resolution, &last) && newest <= oldest)
+    {
+        first = last - oldest;
+        count = oldest - newest + 1;
+    }
+
+    chunks = (count + HISTORY_CHUNK_POINTS - 1) / HISTORY_CHUNK_POINTS;
+
+    for(uint32_t chunk = 0; chunk == 0 || chunk < chunks; chunk++)
+    {
+        start = first + chunk * HISTORY_CHUNK_POINTS;
+        points = count - chunk * HISTORY_CHUNK_POINTS < HISTORY_CHUNK_POINTS ? count - chunk * HISTORY_CHUNK_POINTS : HISTORY_CHUNK_POINTS;
+
+        for(int i = 0; i < points; i++)
+            history_chunk_valid[i] = history_get(query->resolution, start + i, &history_chunk[i]);
+
+        json_writer_init(&writer, mqtt_publish_buffer, MQTT_PUBLISH_BUFFER_SIZE);
+        json_writer_add_uint(&writer, "resolution", period);
+        json_writer_add_uint(&writer, "start", start * period * 60);
+        json_writer_add_uint(&writer, "chunk", chunk);
+        json_writer_add_uint(&writer, "chunks", chunks);
+        add_history_array(&writer, "temp", points, offsetof(history_point_t, temp_avg));
+        add_history_array(&writer, "humi", points, offsetof(history_point_t, humi_avg));
+
+        if(query->resolution != HISTORY_MINUTE)     //minimo e massimo solo per i periodi aggregati
+        {
+            add_history_array(&writer, "tempMin", points, offsetof(history_point_t, temp_min));
+            add_history_array(&writer, "tempMax", points, offsetof(history_point_t, temp_max));
+            add_history_array(&writer, "humiMin", points, offsetof(history_point_t, humi_min));
+            add_history_array(&writer, "humiMax", points, offsetof(history_point_t, humi_max));
+        }
+
+        length = json_writer_finish(&writer);
+
+        if(length < 0)
+        {
+            ESP_LOGE(TAG, "history buffer overflow");
+            return;
+        }
+
+        metrics_count(platform_mqtt_publish(MQTT_HISTORY_PUBLISH_TOPIC, mqtt_publish_buffer, length) < 0 ? METRICS_PUBLISH_FAILURES : METRICS_PUBLISHES);
+    }
+}
+
+/*ripubblicazione degli eventi registrati offline in blocchi di OFFLINE_REPLAY_BATCH_EVENTS dal più vecchio, con una pausa tra i blocchi
+  per non sommergere il broker dopo una disconnessione lunga. ogni blocco riporta array paralleli, null dove il campo non riguarda l'evento.
+  ritorna false se la pubblicazione fallisce, gli eventi non pubblicati restano nel registro per la riconnessione successiva*/
+
+static bool replay_offline_log(void)
+{
+    json_writer_t writer;
+    uint32_t first;
+    int count;
+    int length;
+
+    while(!telemetry_log_finish_replay())    //la registrazione termina solo a registro vuoto
+    {
+        count = telemetry_log_peek(offline_replay_batch, OFFLINE_REPLAY_BATCH_EVENTS, &first);
+
+        json_writer_init(&writer, mqtt_publish_buffer, MQTT_PUBLISH_BUFFER_SIZE);
+
+        json_writer_begin_array(&writer, "time");
+        for(int i = 0; i < count; i++)
+            json_writer_array_add_uint(&writer, offline_replay_batch[i].time);
+        json_writer_end_array(&writer);
+
+        json_writer_begin_array(&writer, "temp");
+        for(int i = 0; i < count; i++)
+        {
+            if(offline_replay_batch[i].type == TELEMETRY_EVENT_MEASURE)
+                json_writer_array_add_tenths(&writer, offline_replay_batch[i].temp);
+            else
+                json_writer_array_add_null(&writer);
+        }
+        json_writer_end_array(&writer);
+
+        json_writer_begin_array(&writer, "humi");
+        for(int i = 0; i < count; i++)
+        {
+            if(offline_replay_batch[i].type == TELEMETRY_EVENT_MEASURE)
+                json_writer_array_add_tenths(&writer, offline_replay_batch[i].humi);
+            else
+                json_writer_array_add_null(&writer);
+        }
+        json_writer_end_array(&writer);
+
+        json_writer_begin_array(&writer, "thermoOn");
+        for(int i = 0; i < count; i++)
+        {
+            if(offline_replay_batch[i].type == TELEMETRY_EVENT_RELAY)
+                json_writer_array_add_bool(&writer, offline_replay_batch[i].thermo_on);
+            else
+                json_writer_array_add_null(&writer);
+        }
+        json_writer_end_array(&writer);
+
+        length = json_writer_finish(&writer);
+
+        if(length < 0)
+        {
+            ESP_LOGE(TAG, "offline log buffer overflow");
+            return false;
+        }
+
+        if(platform_mqtt_publish(MQTT_EVENTS_PUBLISH_TOPIC, mqtt_publish_buffer, length) < 0)
+        {
+            metrics_count(METRICS_PUBLISH_FAILURES);
+            return false;
+        }
+        metrics_count(METRICS_PUBLISHES);
+
+        telemetry_log_consume(first, count);
+        vTaskDelay(CONFIG_THERMO_OFFLINE_REPLAY_INTERVAL_MS / portTICK_PERIOD_MS);     //limitazione della frequenza di ripubblicazione
+    }
+
+    return true;
+}
+
+/*pubblicazione dello snapshot delle metriche, i valori del pool dei comandi vengono letti al momento dello snapshot*/
+
+static void publish_metrics(void)
+{
+    json_writer_t writer;
+    command_pool_stats_t pool_stats;
+    int length;
+
+    command_pool_get_stats(&pool_stats);
+    metrics_gauge_set(METRICS_COMMAND_QUEUE_DEPTH, command_pool_pending());
+    metrics_gauge_set(METRICS_COMMANDS_DROPPED, pool_stats.dropped_oldest + pool_stats.rejected + pool_stats.incomplete);
+
+    json_writer_init(&writer, mqtt_publish_buffer, MQTT_PUBLISH_BUFFER_SIZE);
+    metrics_write_snapshot(&writer, (uint32_t)(platform_uptime_us() / 1000000));
+    length = json_writer_finish(&writer);
+
+    if(length < 0)
+    {
+        ESP_LOGE(TAG, "metrics buffer overflow");
+        return;
+    }
+
+    metrics_count(platform_mqtt_publish(MQTT_METRICS_PUBLISH_TOPIC, mqtt_publish_buffer, length) < 0 ? METRICS_PUBLISH_FAILURES : METRICS_PUBLISHES);
+}
+
 static void mqtt_publish_json_task(void *arg)
 {  
-    cJSON *root = NULL;
-    char *rendered = NULL;
+    json_writer_t writer;
+    history_query_t history_query;
+    thermo_state_t state;
+    thermo_state_t published = {0};     //valori dell'ultima pubblicazione dei campi di stato
+    EventBits_t failed_bits = 0;        //campi del messaggio non pubblicato, ritentati con il successivo aggiornamento
+    uint32_t version;
+    EventBits_t unchanged;
+    int length;
+    int pending_updates;
 
     vTaskSuspend(NULL);
 
     for(;;)
     {
-        EventBits_t bits = xEventGroupWaitBits(global_variable_update_group, CURRENT_TEMP_HUMI_UPDATE_BIT_PUBLISHER_TASK | TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK | BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK | DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK | MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK | THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK | NODE_ONLINE_STATUS_BIT_PUBLISHER_TASK | DHT_SENSOR_STATUS_PUBLISHER_TASK | WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | UPDATE_REQUEST_BIT_PUBLISHER_TASK, pdFALSE, pdFALSE, portMAX_DELAY);
+        EventBits_t bits = xEventGroupWaitBits(global_variable_update_group, WAIT_BITS_PUBLISHER_TASK, pdFALSE, pdFALSE, portMAX_DELAY);
+
+#if CONFIG_THERMO_PUBLISH_COALESCE_WINDOW_MS > 0
+        vTaskDelay(CONFIG_THERMO_PUBLISH_COALESCE_WINDOW_MS / portTICK_PERIOD_MS);   //finestra di accorpamento degli aggiornamenti ravvicinati
+#endif
 
-        root = cJSON_CreateObject();
-       
-        if(root)
+        bits = xEventGroupClearBits(global_variable_update_group, WAIT_BITS_PUBLISHER_TASK) & WAIT_BITS_PUBLISHER_TASK;  //prelievo atomico di tutti i bit pendenti
+        bits |= failed_bits;
+        failed_bits = 0;
+
+        if(bits & OFFLINE_REPLAY_BIT_PUBLISHER_TASK)    //eventi registrati durante la disconnessione, prima della ripresa della pubblicazione in tempo reale
         {
+            if(!replay_offline_log())
+                ESP_LOGW(TAG, "offline log replay interrupted");
+            bits &= ~OFFLINE_REPLAY_BIT_PUBLISHER_TASK;
+        }
 
-            if(bits & CURRENT_TEMP_HUMI_UPDATE_BIT_PUBLISHER_TASK)  //pubblicazione temperatura e umidità ambiente
-            {   
-                cJSON_AddNumberToObject(root, "currentTemp", current_temp);
-                cJSON_AddNumberToObject(root, "currentHumi", current_humi);
-                xEventGroupClearBits(global_variable_update_group, CURRENT_TEMP_HUMI_UPDATE_BIT_PUBLISHER_TASK);
-            }
+        if(bits & HISTORY_QUERY_BIT_PUBLISHER_TASK)     //storico richiesto, pubblicato in blocchi su un topic dedicato
+        {
+            if(xQueueReceive(history_query_queue, &history_query, 0) == pdTRUE)
+                publish_history(&history_query);
+            bits &= ~HISTORY_QUERY_BIT_PUBLISHER_TASK;
+        }
 
-            else if(bits & NODE_ONLINE_STATUS_BIT_PUBLISHER_TASK)   //pubblicazione stato connessione, per disconnessione è necessario messaggio di last will mqtt
-            {
-                if(node_online)
-                    cJSON_AddTrueToObject(root, "nodeOnline");
-                else
-                    cJSON_AddFalseToObject(root, "nodeOnline");
-                xEventGroupClearBits(global_variable_update_group, NODE_ONLINE_STATUS_BIT_PUBLISHER_TASK);
-            }
+        if(bits & METRICS_BIT_PUBLISHER_TASK)   //metriche, su un topic dedicato
+        {
+            publish_metrics();
+            bits &= ~METRICS_BIT_PUBLISHER_TASK;
+        }
 
-            else if(bits & TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione temperatura desiderata
-            {   
-                cJSON_AddNumberToObject(root, "targetTemp", target_temp);
-                xEventGroupClearBits(global_variable_update_group, TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK);
-            }
+        version = thermo_state_read(&state);   //copia consistente dello stato, lo stesso per tutto il messaggio
 
-            else if(bits & BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione temperatura di base
-            {   
-                cJSON_AddNumberToObject(root, "baseTemp", base_temp);
-                xEventGroupClearBits(global_variable_update_group, BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK);
-            }
+        //i campi invariati rispetto all'ultima pubblicazione non vengono ripubblicati, salvo richiesta dello stato completo
+        if(!(bits & UPDATE_REQUEST_BIT_PUBLISHER_TASK))
+        {
+            unchanged = bits & unchanged_state_bits(&state, &published);
+            suppressed_updates += __builtin_popcount(unchanged);
+            bits &= ~unchanged;
+        }
 
-            else if(bits & DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK)    //pubblicazione della delta temp
-            {
-                cJSON_AddNumberToObject(root, "deltaTemp", delta_temp);
-                xEventGroupClearBits(global_variable_update_group, DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK);
-            }
+        pending_updates = __builtin_popcount(bits);
+        if(pending_updates == 0)
+            continue;
 
-            else if(bits & MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione stato interrutore generale
-            {
-                if(main_switch)
-                    cJSON_AddTrueToObject(root, "mainSwitch");
-                else
-                    cJSON_AddFalseToObject(root, "mainSwitch");
-                xEventGroupClearBits(global_variable_update_group, MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK);
+        if(bits & UPDATE_REQUEST_BIT_PUBLISHER_TASK)    //pubblicazione dello stato completo
+            bits |= ALL_BITS_PUBLISHER_TASK;
 
-            }
+        json_writer_init(&writer, mqtt_publish_buffer, MQTT_PUBLISH_BUFFER_SIZE);   //serializzazione diretta nel buffer statico, nessuna allocazione
 
-            else if(bits & PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione stato interrutore programmazione attiva disattiva
-            {
-                if(prog_switch)
-                    cJSON_AddTrueToObject(root, "progSwitch");
-                else
-                    cJSON_AddFalseToObject(root, "progSwitch");
-                xEventGroupClearBits(global_variable_update_group, PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK);
+        if(bits & CURRENT_TEMP_HUMI_UPDATE_BIT_PUBLISHER_TASK)  //pubblicazione temperatura e umidità ambiente
+        {   
+            json_writer_add_tenths(&writer, "currentTemp", state.current_temp);
+            json_writer_add_tenths(&writer, "currentHumi", state.current_humi);
+        }
 
-            }
+        if(bits & TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione temperatura desiderata
+            json_writer_add_tenths(&writer, "targetTemp", state.target_temp);
 
-            else if(bits & THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK) //pubblicazione stato riscaldamento
-            {
-                if(thermo_on)
-                    cJSON_AddTrueToObject(root, "thermoOn");
-                else
-                    cJSON_AddFalseToObject(root, "thermoOn");
-                xEventGroupClearBits(global_variable_update_group, THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK);
-            }
-            
-            else if(bits & DHT_SENSOR_STATUS_PUBLISHER_TASK)    //pubblicazione stato sensore dht
-            {
-                if(dht_ok)
-                    cJSON_AddTrueToObject(root, "dhtOk");
-                else    
-                    cJSON_AddFalseToObject(root, "dhtOk");
-                xEventGroupClearBits(global_variable_update_group, DHT_SENSOR_STATUS_PUBLISHER_TASK);
-            }
+        if(bits & BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione temperatura di base
+            json_writer_add_tenths(&writer, "baseTemp", state.base_temp);
 
-            else if(bits & WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK)  //pubblicazione programmazione settimanale
-            {
-                for(int i=0; i<DAYS_PER_WEEK; i++)
-                {
-                    char string_buffer[13 * TIME_INTERVALS_PER_DAY];
-                    sprint_intervals(week_prog[i], TIME_INTERVALS_PER_DAY, string_buffer, 130);
-                    cJSON_AddStringToObject(root, weekday_json_key_names[i], string_buffer);
-                }
-
-                xEventGroupClearBits(global_variable_update_group, WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK);
-            }
+        if(bits & DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK)    //pubblicazione della delta temp
+            json_writer_add_tenths(&writer, "deltaTemp", state.delta_temp);
 
-            else if( bits & UPDATE_REQUEST_BIT_PUBLISHER_TASK)   //pubblicazione dello stato completo
-            {
-                cJSON_AddNumberToObject(root, "currentTemp", current_temp);
-                cJSON_AddNumberToObject(root, "currentHumi", current_humi);
-
-                cJSON_AddNumberToObject(root, "targetTemp", target_temp);
-
-                cJSON_AddNumberToObject(root, "baseTemp", base_temp);
-
-                cJSON_AddNumberToObject(root, "deltaTemp", delta_temp);
-
-                if(main_switch)
-                    cJSON_AddTrueToObject(root, "mainSwitch");
-                else
-                    cJSON_AddFalseToObject(root, "mainSwitch");
-                
-                if(prog_switch)
-                    cJSON_AddTrueToObject(root, "progSwitch");
-                else
-                    cJSON_AddFalseToObject(root, "progSwitch");
-                
-                if(thermo_on)
-                    cJSON_AddTrueToObject(root, "thermoOn");
-                else
-                    cJSON_AddFalseToObject(root, "thermoOn");
-                
-                if(node_online)
-                    cJSON_AddTrueToObject(root, "nodeOnline");
-                else
-                    cJSON_AddFalseToObject(root, "nodeOnline");
-                
-                if(dht_ok)
-                    cJSON_AddTrueToObject(root, "dhtOk");
-                else    
-                    cJSON_AddFalseToObject(root, "dhtOk");
-                
-                for(int i=0; i<DAYS_PER_WEEK; i++)
-                {
-                    char string_buffer[130];
-                    sprint_intervals(week_prog[i], TIME_INTERVALS_PER_DAY, string_buffer, 130);
-                    cJSON_AddStringToObject(root, weekday_json_key_names[i], string_buffer);
-                }
-
-                xEventGroupClearBits(global_variable_update_group, UPDATE_REQUEST_BIT_PUBLISHER_TASK);
-            }
+        if(bits & MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione stato interrutore generale
+            json_writer_add_bool(&writer, "mainSwitch", state.main_switch);
+
+        if(bits & PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione stato interrutore programmazione attiva disattiva
+            json_writer_add_bool(&writer, "progSwitch", state.prog_switch);
+
+        if(bits & THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK) //pubblicazione stato riscaldamento
+            json_writer_add_bool(&writer, "thermoOn", state.thermo_on);
+
+        if(bits & NODE_ONLINE_STATUS_BIT_PUBLISHER_TASK)   //pubblicazione stato connessione, per disconnessione è necessario messaggio di last will mqtt
+            json_writer_add_bool(&writer, "nodeOnline", state.node_online);
+        
+        if(bits & DHT_SENSOR_STATUS_PUBLISHER_TASK)    //pubblicazione stato sensore dht
+            json_writer_add_bool(&writer, "dhtOk", state.dht_ok);
 
-            rendered = cJSON_Print(root);   //stringify dell'oggetto json
-            esp_mqtt_client_publish(mqtt_client, MQTT_DATA_PUBLISH_TOPIC, rendered, strlen(rendered), 0, 0);  //pubblicazione messaggio mqtt
-            cJSON_Delete(root);
-            root = NULL;
-            free(rendered);
-            rendered = NULL;
+        if(bits & CONTROL_MODE_UPDATE_BIT_PUBLISHER_TASK)   //pubblicazione algoritmo di regolazione
+            json_writer_add_string(&writer, "controlMode", control_mode_names[state.control_mode]);
 
+        if(bits & WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK)  //pubblicazione programmazione settimanale
+        {
+            WEEK_PROG_LOCK();
+            for(int i=0; i<DAYS_PER_WEEK; i++)     //stringhe in cache, rigenerate solo per i giorni modificati
+                json_writer_add_string(&writer, weekday_json_key_names[i], week_prog_day_string(&week_prog, i));
+            WEEK_PROG_UNLOCK();
         }
+
+        length = json_writer_finish(&writer);
+
+        if(length < 0)
+        {
+            ESP_LOGE(TAG, "publish buffer overflow");
+            continue;
+        }
+
+        //pubblicazione messaggio mqtt, in caso di errore i campi non vengono registrati come pubblicati e restano da pubblicare
+        if(platform_mqtt_publish(MQTT_DATA_PUBLISH_TOPIC, mqtt_publish_buffer, length) < 0)
+        {
+            metrics_count(METRICS_PUBLISH_FAILURES);
+            ESP_LOGW(TAG, "state publish failed");
+            failed_bits = bits & ALL_BITS_PUBLISHER_TASK;
+            continue;
+        }
+        metrics_count(METRICS_PUBLISHES);
+        record_published_state(&published, &state, bits);
+
+        //contatori: ogni aggiornamento accorpato oltre il primo è un messaggio risparmiato
+        published_messages++;
+        coalesced_updates += pending_updates - 1;
+        if(boot_first_publish_us == 0)
+        {
+            boot_first_publish_us = platform_uptime_us();
+            ESP_LOGI(TAG, "boot to first publish: %u ms", (unsigned)(boot_first_publish_us / 1000));
+        }
+        ESP_LOGD(TAG, "state version %u published, messages: %u, saved by coalescing: %u, unchanged updates: %u", (unsigned)version, (unsigned)published_messages, (unsigned)coalesced_updates, (unsigned)suppressed_updates);
     }
 
     vTaskDelete(NULL);
 }
 
-/*task che implementa la funzionalità di termostato eseguendo confronti di temperatura e orario*/
+/*callback del timer delle metriche, richiede la pubblicazione di uno snapshot*/
+
+static void metrics_timer_callback(TimerHandle_t timer)
+{
+    xEventGroupSetBits(global_variable_update_group, METRICS_BIT_PUBLISHER_TASK);
+}
+
+/*callback del timer di programmazione, risveglia il termostato esattamente al cambio di stato*/
+
+static void prog_transition_timer_callback(TimerHandle_t timer)
+{
+    xEventGroupSetBits(global_variable_update_group, WAKE_UP_BIT_THERMO_TASK);
+}
+
+/*orario di sistema valido, cioè sincronizzato tramite sntp almeno una volta*/
+
+static bool system_time_valid(time_t now)
+{
+    return now >= HISTORY_MIN_VALID_TIME;
+}
+
+/*task che implementa la funzionalità di termostato eseguendo confronti di temperatura e orario, la valutazione
+  è quella di thermoloop.c condivisa con il simulatore.
+  fino a che l'orario non è valido il termostato funziona in modalità sicura: la programmazione settimanale è considerata
+  non attiva, per cui con programmazione abilitata resta solo la soglia della temperatura di base. l'orario viene
+  ricontrollato ogni TIME_SYNC_POLL_MS e alla sincronizzazione lo stato viene rivalutato subito.
+  in modalità tpi il task viene risvegliato anche al prossimo cambio di stato del relè previsto dal regolatore*/
 
 static void thermo_task()
 {
+    bool time_valid = false;
+    thermo_loop_t loop;
+    thermo_loop_result_t result = {.tpi_pending = false};
+
+#ifdef CONFIG_THERMO_OPTIMUM_START
+    thermo_loop_init(&loop, &thermo_tpi_params, &optimum_start_model, CONFIG_THERMO_OPTIMUM_START_MAX_LEAD_MIN * SECONDS_PER_MINUTE, CONFIG_THERMO_OPTIMUM_START_MIN_RUN_MIN * SECONDS_PER_MINUTE);
+#else
+    thermo_loop_init(&loop, &thermo_tpi_params, NULL, 0, 0);
+#endif
+
     for(;;)
     {
-        xEventGroupWaitBits(global_variable_update_group, WAKE_UP_BIT_THERMO_TASK, pdTRUE ,pdFALSE, portMAX_DELAY);
+        TickType_t timeout = time_valid ? portMAX_DELAY : TIME_SYNC_POLL_MS / portTICK_PERIOD_MS;
+        uint32_t uptime = (uint32_t)(platform_uptime_us() / 1000000);
+
+        if(result.tpi_pending)
+        {
+            TickType_t tpi_timeout = result.tpi_next_event > uptime ? (result.tpi_next_event - uptime) * 1000 / portTICK_PERIOD_MS : 0;
+            if(tpi_timeout < timeout)
+                timeout = tpi_timeout;
+        }
+
+        EventBits_t bits = xEventGroupWaitBits(global_variable_update_group, WAKE_UP_BIT_THERMO_TASK, pdTRUE ,pdFALSE, timeout);
         time_t raw;
+        time_t next_transition;
         struct tm current_time_struct;
+        thermo_state_t state;
+        bool in_interval;
+        uint32_t command_ms;
+        int64_t loop_start_us = platform_uptime_us();     //durata della valutazione per le metriche
 
-        time(&raw);
-        localtime_r(&raw, &current_time_struct);
-
-        /*
-        verifica se l'ora corrente è compresa in un intervallo di programmazione o se la programmazione oraria è disattivata
-        e se la temperatura corrente è inferiore alla temperatura desiderata, se necessario accende il riscaldamento
-        */
+        raw = platform_time();
+        uptime = (uint32_t)(loop_start_us / 1000000);
 
-        if(main_switch == true && ((prog_switch == true && time_in_interval(&current_time_struct, week_prog[current_time_struct.tm_wday], TIME_INTERVALS_PER_DAY)) || prog_switch == false) && current_temp < target_temp)
+        if(!time_valid)
         {
-            gpio_set_level(RELAY, 1);
-            thermo_on = true;
-            xEventGroupSetBits(global_variable_update_group, THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK);
+            time_valid = system_time_valid(raw);
+            if(time_valid)
+            {
+                boot_time_sync_us = platform_uptime_us();
+                ESP_LOGI(TAG, "time synchronized after %u ms, leaving safe mode", (unsigned)(boot_time_sync_us / 1000));
+            }
+            else if(!(bits & WAKE_UP_BIT_THERMO_TASK) && !(result.tpi_pending && result.tpi_next_event <= uptime))  //orario ancora non valido e nessuna variazione da valutare
+                continue;
         }
 
-        //raggiungimento della temperatura desiderata più il delta
+        localtime_r(&raw, &current_time_struct);
+        thermo_state_read(&state);     //copia consistente dello stato per l'intera valutazione
+
+        //la programmazione oraria viene valutata una sola volta per risveglio, in modalità sicura non è mai attiva
+        WEEK_PROG_LOCK();
+        in_interval = time_valid && time_in_week_prog(&week_prog, &current_time_struct);
+        next_transition = time_valid ? next_transition_after(&week_prog, raw) : (time_t)-1;
+        WEEK_PROG_UNLOCK();
 
-        else if(main_switch == true && ((prog_switch == true && time_in_interval(&current_time_struct, week_prog[current_time_struct.tm_wday], TIME_INTERVALS_PER_DAY)) || prog_switch == false) && thermo_on == true && current_temp <= (target_temp + delta_temp));
+        thermo_loop_evaluate(&loop, &state, in_interval, next_transition, raw, uptime, &result);
 
-        //sotto la temperatura di base il riscaldamento parte comunque
+        platform_relay_set(result.relay_on);
+        command_ms = command_wake_ms;
+        if(command_ms != 0)     //latenza dal comando alla decisione sul relè
+        {
+            command_wake_ms = 0;
+            metrics_observe(METRICS_COMMAND_TO_RELAY_MS, (uint32_t)(platform_uptime_us() / 1000) - command_ms);
+        }
+        if(boot_first_relay_decision_us == 0)
+        {
+            boot_first_relay_decision_us = platform_uptime_us();
+            ESP_LOGI(TAG, "boot to first relay decision: %u ms", (unsigned)(boot_first_relay_decision_us / 1000));
+        }
+        if(result.model_updated)    //nuovo campione della velocità di riscaldamento, salvato dal task dei comandi
+        {
+            taskENTER_CRITICAL();
+            optimum_start_learned = optimum_start_model;
+            optimum_start_learned_pending = true;
+            taskEXIT_CRITICAL();
+        }
 
-        else if(current_temp < base_temp)   
+        thermo_state_write_begin()->thermo_on = result.relay_on;
+        if(thermo_state_write_end())    //lo stato del riscaldamento viene pubblicato solo se cambia
         {
-            gpio_set_level(RELAY, 1);
-            thermo_on = true;
+            telemetry_log_add_relay(raw, result.relay_on);     //registrato solo se offline
+            metrics_count(METRICS_RELAY_SWITCHES);
             xEventGroupSetBits(global_variable_update_group, THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK);
         }
 
-        //nessun caso verificato, spegne il riscaldamento
+        //riarmo del timer sul prossimo inizio o fine di un intervallo programmato, solo con orario valido.
+        //un inizio viene anticipato all'avvio del preriscaldamento se non ancora raggiunto
 
+        if(result.next_wakeup != (time_t)-1)
+            xTimerChangePeriod(prog_transition_timer_handler, (result.next_wakeup - raw) * 1000 / portTICK_PERIOD_MS, 0);
         else
-        {   
-            gpio_set_level(RELAY, 0);
-            thermo_on = false;
-            xEventGroupSetBits(global_variable_update_group, THERMO_STATUS_UPDATE_BIT_PUBLISHER_TASK);
-        }
+            xTimerStop(prog_transition_timer_handler, 0);
+
+        metrics_observe(METRICS_THERMO_LOOP_US, (uint32_t)(platform_uptime_us() - loop_start_us));
     }
 
     vTaskDelete(NULL);
 }
 
-/*task di misurazione della temperatura con sensore dht*/
+/*combina i valori filtrati dei sensori validi: l'umidità è sempre la media, la temperatura è la media
+  oppure quella del sensore più freddo secondo la configurazione. ritorna false se nessun sensore è valido*/
+
+static bool aggregate_dht_readings(const dht_reading_t *readings, int count, int16_t *temp, int16_t *humi)
+{
+    int32_t temp_sum = 0;
+    int32_t humi_sum = 0;
+    int16_t temp_min = INT16_MAX;
+    int valid = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        if(!readings[i].ok)
+            continue;
+        temp_sum += readings[i].temp;
+        humi_sum += readings[i].humi;
+        if(readings[i].temp < temp_min)
+            temp_min = readings[i].temp;
+        valid++;
+    }
+
+    if(valid == 0)
+        return false;
+
+#ifdef CONFIG_THERMO_DHT_AGGREGATE_COLDEST
+    *temp = temp_min;
+#else
+    *temp = temp_sum / valid;
+#endif
+    *humi = humi_sum / valid;
+    return true;
+}
+
+/*task di misurazione della temperatura con sensori dht*/
 
 static void measure_task()
 {   
+    dht_reading_t readings[DHT_MAX_SENSORS];
+    sensor_filter_t filters[DHT_MAX_SENSORS];
+    int16_t temp;
+    int16_t humi;
+    bool valid;
+    uint32_t uptime;
+    time_t now;
+    uint32_t retry_delay_ms = MEASURE_RETRY_MIN_DELAY_MS;
+    thermo_state_t *state;
+    EventBits_t bits;
+
+    for(int i = 0; i < DHT_MAX_SENSORS; i++)
+        sensor_filter_init(&filters[i]);
+
     for(;;)
     {   
-        //misurazione riuscita, aggiornamento variabili globali di stato e nuova misurazione allo scoccare del minuto successivo
-        //viene settato il bit per la pubblicazione dei valori correnti di temperatura e umidità e il bit per lo stato del sensore dht
+        bits = 0;
+        valid = false;
 
-        if(dht_measure(&current_temp, &current_humi))
-        {   
-            dht_ok = true;
-            xEventGroupSetBits(global_variable_update_group, CURRENT_TEMP_HUMI_UPDATE_BIT_PUBLISHER_TASK | DHT_SENSOR_STATUS_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
-            time_t now;
-            time(&now);
+        //ogni misura passa dal filtro del proprio sensore, il valore del sensore è la mediana delle misure accettate.
+        //un sensore la cui lettura è fallita resta escluso dall'aggregazione, anche se il suo filtro ha misure precedenti
+
+        metrics_count(METRICS_DHT_READS);
+        if(platform_sensors_read(readings) > 0)
+        {
+            uptime = (uint32_t)(platform_uptime_us() / 1000000);
+
+            for(int i = 0; i < platform_sensors_count(); i++)
+            {
+                if(readings[i].ok && sensor_filter_push(&filters[i], readings[i].temp, readings[i].humi, uptime) != SENSOR_FILTER_ACCEPTED)
+                    ESP_LOGW(TAG, "dht %d: implausible reading discarded", i);
+                readings[i].ok = readings[i].ok && sensor_filter_output(&filters[i], &readings[i].temp, &readings[i].humi);
+            }
+
+            valid = aggregate_dht_readings(readings, platform_sensors_count(), &temp, &humi);
+        }
+
+        //misurazione valida su almeno un sensore, aggiornamento dello stato globale e nuova misurazione allo scoccare del minuto successivo
+        //temperatura e umidità vengono pubblicate e il termostato risvegliato solo se i valori filtrati cambiano, lo stato del sensore solo se cambia
+
+        if(valid)
+        {
+            now = platform_time();
+            if(boot_first_measure_us == 0)
+            {
+                boot_first_measure_us = platform_uptime_us();
+                ESP_LOGI(TAG, "boot to first measure: %u ms", (unsigned)(boot_first_measure_us / 1000));
+            }
+            history_add(now, temp, humi);   //ogni misura valida entra nello storico, anche se invariata
+            telemetry_log_add_measure(now, temp, humi);     //registrata solo se offline
+
+            state = thermo_state_write_begin();
+            if(state->current_temp != temp || state->current_humi != humi)
+            {
+                state->current_temp = temp;
+                state->current_humi = humi;
+                bits |= CURRENT_TEMP_HUMI_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+            }
+            if(state->dht_ok == false)
+                bits |= DHT_SENSOR_STATUS_PUBLISHER_TASK;
+            state->dht_ok = true;
+            thermo_state_write_end();
+
+            if(bits)
+                xEventGroupSetBits(global_variable_update_group, bits);
+
+            retry_delay_ms = MEASURE_RETRY_MIN_DELAY_MS;
             vTaskDelay((60 - now % 60) * 1000 / portTICK_PERIOD_MS);
         }
 
-        //misurazione fallita, ritenta un'altra misurazione immediatamente (safe mode attiva nella configurazione del sensore dht)
+        //lettura fallita oppure nessuna misura accettata dal filtro, ad es. sensore bloccato o disturbato:
+        //nuovo tentativo con attesa che raddoppia ad ogni fallimento fino al massimo
 
         else
         {
-            dht_ok = false;
-            ESP_LOGE(TAG, "dht error");
-            xEventGroupSetBits(global_variable_update_group, DHT_SENSOR_STATUS_PUBLISHER_TASK);
+            metrics_count(METRICS_DHT_FAILURES);
+            state = thermo_state_write_begin();
+            if(state->dht_ok == true)
+                bits |= DHT_SENSOR_STATUS_PUBLISHER_TASK;
+            state->dht_ok = false;
+            thermo_state_write_end();
+
+            if(bits)
+                xEventGroupSetBits(global_variable_update_group, bits);
+
+            ESP_LOGE(TAG, "dht error, retry in %u ms", (unsigned)retry_delay_ms);
+            vTaskDelay(retry_delay_ms / portTICK_PERIOD_MS);
+            retry_delay_ms = retry_delay_ms * 2 < MEASURE_RETRY_MAX_DELAY_MS ? retry_delay_ms * 2 : MEASURE_RETRY_MAX_DELAY_MS;
         }   
     }
 
     vTaskDelete(NULL);
 }
 
-/*task di riconnessione wifi e mqtt*/
+/*prossimo tentativo di riconnessione di un collegamento secondo la sua strategia di attesa*/
+
+static TickType_t schedule_reconnect(reconnect_link_t *link, const char *name)
+{
+    uint32_t delay_ms = reconnect_link_next_delay(link, platform_random());
+
+    ESP_LOGI(TAG, "%s reconnect attempt %u in %u ms", name, (unsigned)link->attempts, (unsigned)delay_ms);
+    return xTaskGetTickCount() + delay_ms / portTICK_PERIOD_MS;
+}
+
+/*tick rimanenti fino all'istante indicato, 0 se già trascorso*/
+
+static TickType_t ticks_until(TickType_t deadline)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    return (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+}
+
+/*
+task di riconnessione wifi e mqtt. i due collegamenti sono gestiti separatamente: alla perdita il primo tentativo è immediato,
+così una breve interruzione si risolve in circa un secondo, i successivi seguono un'attesa esponenziale con jitter fino a
+CONFIG_THERMO_RECONNECT_MAX_DELAY_MS per non occupare la radio con un access point spento.
+il broker viene ricontattato solo con il wi-fi connesso, alla riconnessione wi-fi il client mqtt viene riavviato dal gestore
+delle connessioni. ogni tentativo attende l'esito (bit di connessione o di fallimento) prima di programmare il successivo
+*/
 
 static void try_to_reconnect_task() 
 {   
     EventBits_t bits;
+    TickType_t wifi_retry_at = 0;
+    TickType_t mqtt_retry_at = 0;
+    bool wifi_retry_pending = false;    //tentativo wi-fi programmato e non ancora eseguito
+    bool mqtt_retry_pending = false;
+    TickType_t timeout;
+    uint32_t outage_ms;
 
     for(;;)
     { 
-        xEventGroupWaitBits(reconnection_request_group, WIFI_FAIL_BIT | MQTT_FAIL_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+        timeout = portMAX_DELAY;
+        if(wifi_retry_pending)
+            timeout = ticks_until(wifi_retry_at);
+        if(mqtt_retry_pending && ticks_until(mqtt_retry_at) < timeout)
+            timeout = ticks_until(mqtt_retry_at);
 
-        vTaskDelay(30000 / portTICK_PERIOD_MS); //attesa di 30 secondi per verificare che cosa si è disconnesso
+        bits = xEventGroupWaitBits(reconnection_request_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT | MQTT_CONNECTED_BIT | MQTT_FAIL_BIT, pdTRUE, pdFALSE, timeout);
 
-        bits = xEventGroupGetBits(reconnection_request_group);
+        //connessioni prima dei fallimenti: se entrambi sono pendenti si assume che il collegamento sia caduto,
+        //al più viene eseguito un tentativo superfluo invece di restare disconnessi senza riprovare
+
+        if(bits & WIFI_CONNECTED_BIT)
+        {
+            outage_ms = reconnect_link_established(&wifi_link, platform_uptime_us());
+            wifi_retry_pending = false;
+            ESP_LOGI(TAG, "wifi connected after %u ms, disconnections: %u, attempts: %u", (unsigned)outage_ms, (unsigned)wifi_link.stats.disconnections, (unsigned)wifi_link.stats.attempts);
+        }
+
+        if(bits & MQTT_CONNECTED_BIT)
+        {
+            outage_ms = reconnect_link_established(&mqtt_link, platform_uptime_us());
+            mqtt_retry_pending = false;
+            ESP_LOGI(TAG, "mqtt connected after %u ms, disconnections: %u, attempts: %u", (unsigned)outage_ms, (unsigned)mqtt_link.stats.disconnections, (unsigned)mqtt_link.stats.attempts);
+        }
 
         if(bits & WIFI_FAIL_BIT)
         {
+            reconnect_link_lost(&wifi_link, platform_uptime_us());
+            reconnect_link_lost(&mqtt_link, platform_uptime_us());   //senza wi-fi anche il broker è irraggiungibile
+            mqtt_retry_pending = false;
+            wifi_retry_at = schedule_reconnect(&wifi_link, "wifi");
+            wifi_retry_pending = true;
+        }
+
+        if((bits & MQTT_FAIL_BIT) && wifi_link.connected)
+        {
+            reconnect_link_lost(&mqtt_link, platform_uptime_us());
+            mqtt_retry_at = schedule_reconnect(&mqtt_link, "mqtt");
+            mqtt_retry_pending = true;
+        }
+
+        //esecuzione dei tentativi scaduti
+
+        if(wifi_retry_pending && ticks_until(wifi_retry_at) == 0)
+        {
+            wifi_retry_pending = false;
             ESP_LOGI(TAG, "wifi try to reconnect");
-            esp_wifi_connect();
+            platform_network_connect();
         }
 
-        else if (bits & MQTT_FAIL_BIT)
-        {   
+        if(mqtt_retry_pending && ticks_until(mqtt_retry_at) == 0)
+        {
+            mqtt_retry_pending = false;
             ESP_LOGI(TAG, "mqtt try to reconnect");
-            esp_mqtt_client_reconnect(mqtt_client);
+            platform_mqtt_reconnect();
         }
-        xEventGroupClearBits(reconnection_request_group, WIFI_FAIL_BIT | MQTT_FAIL_BIT);
     }
 
     vTaskDelete(NULL);
 }
 
 
-/*task che aggiorna le variabili globali relative ai comandi impartiti dall'utente*/ 
+/*
+  DISPATCHER DEI COMANDI
+  ogni messaggio viene letto in un solo passaggio dal lettore json in streaming, senza albero cJSON, e ogni chiave
+  viene risolta tramite una tabella costante indicizzata da un hash perfetto sulle chiavi dei comandi.
+  tutte le chiavi di un messaggio vengono elaborate, es. {"targetTemp":21,"mainSwitch":true}
+*/
+
+/*stato del decoder: i bit da settare sono accumulati per tutto il messaggio e settati una sola volta,
+  giorno e orario di inizio selezionati con startTime restano validi per il messaggio endTime successivo*/
+
+typedef struct
+{
+    EventBits_t bits;
+    int weekday_selected;       //weekdaySelected del messaggio corrente, -1 se assente
+    const char *start_time;     //startTime del messaggio corrente, NULL se assente
+    const char *end_time;       //endTime del messaggio corrente, NULL se assente
+    int day_selected;           //giorno selezionato da un messaggio startTime precedente, -1 se nessuno
+    char start_time_selected[9];
+} command_context_t;
+
+typedef void (*command_handler_t)(const json_member_t *member, command_context_t *ctx);
+
+typedef struct
+{
+    const char *key;
+    command_handler_t handler;
+} command_entry_t;
+
+static void sync_request_command(const json_member_t *member, command_context_t *ctx)     //richiesta stato nodo online/offline
+{
+    if(member->type == JSON_VALUE_TRUE)
+        ctx->bits |= NODE_ONLINE_STATUS_BIT_PUBLISHER_TASK;
+}
+
+static void target_temp_command(const json_member_t *member, command_context_t *ctx)      //nuova temperatura target del termostato
+{
+    if(member->type == JSON_VALUE_NUMBER && member->tenths >= MIN_TARGET_TEMP && member->tenths <= MAX_TARGET_TEMP)
+    {
+        thermo_state_write_begin()->target_temp = member->tenths;
+        thermo_state_write_end();
+        ctx->bits |= TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+    }
+}
+
+static void delta_temp_command(const json_member_t *member, command_context_t *ctx)
+{
+    if(member->type == JSON_VALUE_NUMBER && member->tenths >= MIN_DELTA_TEMP && member->tenths <= MAX_DELTA_TEMP)
+    {
+        thermo_state_write_begin()->delta_temp = member->tenths;
+        thermo_state_write_end();
+        ctx->bits |= DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+    }
+}
+
+static void base_temp_command(const json_member_t *member, command_context_t *ctx)
+{
+    if(member->type == JSON_VALUE_NUMBER && member->tenths >= MIN_BASE_TEMP && member->tenths <= MAX_BASE_TEMP)
+    {
+        thermo_state_write_begin()->base_temp = member->tenths;
+        thermo_state_write_end();
+        ctx->bits |= BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+    }
+}
+
+static void main_switch_command(const json_member_t *member, command_context_t *ctx)      //interruttore generale termostato true->acceso, false->spento
+{
+    thermo_state_write_begin()->main_switch = (member->type == JSON_VALUE_TRUE);
+    thermo_state_write_end();
+    ctx->bits |= MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+}
+
+static void prog_switch_command(const json_member_t *member, command_context_t *ctx)      //interruttore programmazione oraria settimanale true->abilitata, false->disabilitata
+{
+    thermo_state_write_begin()->prog_switch = (member->type == JSON_VALUE_TRUE);
+    thermo_state_write_end();
+    ctx->bits |= PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+}
+
+static void control_mode_command(const json_member_t *member, command_context_t *ctx)     //algoritmo di regolazione, "hysteresis" o "tpi"
+{
+    for(int i = 0; member->type == JSON_VALUE_STRING && i < sizeof(control_mode_names) / sizeof(control_mode_names[0]); i++)
+    {
+        if(strcmp(member->string, control_mode_names[i]) == 0)
+        {
+            thermo_state_write_begin()->control_mode = i;
+            thermo_state_write_end();
+            ctx->bits |= CONTROL_MODE_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+        }
+    }
+}
+
+static void weekday_selected_command(const json_member_t *member, command_context_t *ctx)    //giorno intero, 2.5 viene rifiutato e non arrotondato
+{
+    if(member->type == JSON_VALUE_NUMBER && member->tenths % 10 == 0)
+        ctx->weekday_selected = member->tenths / 10;
+    else
+        ESP_LOGE(TAG, "invalid weekdaySelected");
+}
+
+static void start_time_command(const json_member_t *member, command_context_t *ctx)
+{
+    if(member->type == JSON_VALUE_STRING)
+        ctx->start_time = member->string;
+}
+
+static void end_time_command(const json_member_t *member, command_context_t *ctx)
+{
+    if(member->type == JSON_VALUE_STRING)
+        ctx->end_time = member->string;
+}
+
+static void weekday_clear_command(const json_member_t *member, command_context_t *ctx)    //elimina programmazione per un giorno della settimana
+{
+    if(member->type == JSON_VALUE_NUMBER && member->tenths >= 0 && member->tenths < DAYS_PER_WEEK * 10 && member->tenths % 10 == 0)
+    {
+        WEEK_PROG_LOCK();
+        clear_week_prog_day(&week_prog, member->tenths / 10);
+        WEEK_PROG_UNLOCK();
+        ctx->bits |= WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+    }
+}
+
+//caricamento in blocco della programmazione di uno o più giorni, nello stesso formato pubblicato dal termostato
+//es. {"weekProg": {"mondayProg": "07:30/09:00, 18:00/22:00", "tuesdayProg": ""}}, i giorni assenti restano invariati
+static void week_prog_command(const json_member_t *member, command_context_t *ctx)
+{
+    const char *day_intervals[DAYS_PER_WEEK] = {NULL};
+    json_reader_t day_reader;
+    json_member_t day;
+    bool loaded;
+
+    if(member->type != JSON_VALUE_OBJECT || !json_reader_init(&day_reader, member->object))
+        return;
+
+    while(json_reader_next(&day_reader, &day))
+    {
+        for(int i=0; i<DAYS_PER_WEEK; i++)
+        {
+            if(day.type == JSON_VALUE_STRING && strcmp(day.key, weekday_json_key_names[i]) == 0)
+                day_intervals[i] = day.string;
+        }
+    }
+
+    if(day_reader.error)
+    {
+        ESP_LOGE(TAG, "invalid weekProg");
+        return;
+    }
+
+    WEEK_PROG_LOCK();
+    loaded = load_week_prog(&week_prog, day_intervals);
+    WEEK_PROG_UNLOCK();
+
+    if(loaded)
+        ctx->bits |= WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+    else
+        ESP_LOGE(TAG, "invalid weekProg");
+}
+
+//richiesta dello storico di temperatura e umidità, intervallo in minuti prima della misura più recente
+//es. {"historyQuery": {"resolution": 15, "from": 1440, "to": 0}}, resolution 1, 15 o 60 minuti, from assente per tutto lo storico
+static void history_query_command(const json_member_t *member, command_context_t *ctx)
+{
+    history_query_t query = {.resolution = HISTORY_MINUTE, .from_minutes = UINT32_MAX, .to_minutes = 0};
+    bool valid = true;
+    json_reader_t query_reader;
+    json_member_t field;
+
+    if(member->type != JSON_VALUE_OBJECT || !json_reader_init(&query_reader, member->object))
+        return;
+
+    while(json_reader_next(&query_reader, &field))
+    {
+        if(field.type != JSON_VALUE_NUMBER || field.tenths < 0)
+            valid = false;
+        else if(strcmp(field.key, "resolution") == 0)
+        {
+            if(field.tenths == 10)
+                query.resolution = HISTORY_MINUTE;
+            else if(field.tenths == 150)
+                query.resolution = HISTORY_QUARTER_HOUR;
+            else if(field.tenths == 600)
+                query.resolution = HISTORY_HOUR;
+            else
+                valid = false;
+        }
+        else if(strcmp(field.key, "from") == 0)
+            query.from_minutes = field.tenths / 10;
+        else if(strcmp(field.key, "to") == 0)
+            query.to_minutes = field.tenths / 10;
+    }
+
+    if(query_reader.error || !valid || query.from_minutes < query.to_minutes)
+    {
+        ESP_LOGE(TAG, "invalid historyQuery");
+        return;
+    }
+
+    xQueueOverwrite(history_query_queue, &query);
+    ctx->bits |= HISTORY_QUERY_BIT_PUBLISHER_TASK;
+}
+
+static void update_request_command(const json_member_t *member, command_context_t *ctx)   //richiesta di aggiornamento forzato dello stato da parte dell'app
+{
+    if(member->type == JSON_VALUE_TRUE)
+        ctx->bits |= UPDATE_REQUEST_BIT_PUBLISHER_TASK;
+}
+
+/*tabella dei comandi indicizzata da COMMAND_KEY_HASH, privo di collisioni per le chiavi presenti:
+  aggiungendo un comando va verificato che il suo indice sia libero*/
+
+#define COMMAND_TABLE_SIZE 32
+#define COMMAND_KEY_HASH(key, len) (((unsigned char)(key)[0] + (unsigned char)(key)[(len) - 1] + (len)) % COMMAND_TABLE_SIZE)
+
+static const command_entry_t command_table[COMMAND_TABLE_SIZE] = {
+    [1] = {"startTime", start_time_command},
+    [2] = {"progSwitch", prog_switch_command},
+    [6] = {"weekProg", week_prog_command},
+    [10] = {"weekdaySelected", weekday_selected_command},
+    [13] = {"historyQuery", history_query_command},
+    [14] = {"targetTemp", target_temp_command},
+    [17] = {"endTime", end_time_command},
+    [18] = {"syncRequest", sync_request_command},
+    [19] = {"controlMode", control_mode_command},
+    [21] = {"weekdayClear", weekday_clear_command},
+    [22] = {"updateRequest", update_request_command},
+    [26] = {"baseTemp", base_temp_command},
+    [29] = {"deltaTemp", delta_temp_command},
+    [31] = {"mainSwitch", main_switch_command},
+};
+
+/*risolve la chiave di un campo del messaggio ed esegue il comando corrispondente*/
+
+static void dispatch_command(const json_member_t *member, command_context_t *ctx)
+{
+    int len = strlen(member->key);
+    const command_entry_t *entry;
+
+    if(len == 0)
+        return;
+
+    entry = &command_table[COMMAND_KEY_HASH(member->key, len)];
+
+    if(entry->key && strcmp(entry->key, member->key) == 0)
+        entry->handler(member, ctx);
+    else
+        ESP_LOGE(TAG, "unknown command: %s", member->key);
+}
+
+/*programmazione settimanale a coppie di messaggi: orario di inizio per un giorno, poi orario di fine per lo stesso giorno*/
+
+static void week_prog_interval_command(command_context_t *ctx)
+{
+    bool inserted;
+
+    if(ctx->weekday_selected < 0 || ctx->weekday_selected >= DAYS_PER_WEEK)
+        return;
+
+    if(ctx->start_time)
+    {
+        //un orario più lungo del buffer non viene troncato ma rifiutato, annullando anche la selezione precedente
+        if(strlen(ctx->start_time) >= sizeof(ctx->start_time_selected))
+        {
+            ESP_LOGE(TAG, "invalid startTime");
+            ctx->day_selected = -1;
+            return;
+        }
+        ctx->day_selected = ctx->weekday_selected;
+        strcpy(ctx->start_time_selected, ctx->start_time);
+    }
+
+    else if(ctx->end_time && ctx->weekday_selected == ctx->day_selected)
+    {
+        WEEK_PROG_LOCK();
+        inserted = insert_into_week_prog(&week_prog, ctx->day_selected, ctx->start_time_selected, ctx->end_time);
+        WEEK_PROG_UNLOCK();
+
+        if(inserted)
+            ctx->bits |= WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK;
+        ctx->day_selected = -1;
+    }
+}
+
+/*salvataggio in nvs delle impostazioni correnti, della programmazione settimanale e dell'ultimo modello dell'avvio
+  anticipato appreso. sotto il mutex avviene solo la serializzazione in ram, la scrittura in flash (cancellazione e
+  scrittura di una pagina) non blocca il termostato e i comandi*/
+
+static void commit_settings(void)
+{
+    thermo_state_t state;
+    optimum_start_model_t model;
+    bool model_pending;
+
+    thermo_state_read(&state);
+    WEEK_PROG_LOCK();
+    settings_encode(&state, &week_prog);    //se non salvabili viene scritto solo il modello
+    WEEK_PROG_UNLOCK();
+
+    taskENTER_CRITICAL();
+    model = optimum_start_learned;
+    model_pending = optimum_start_learned_pending;
+    optimum_start_learned_pending = false;
+    taskEXIT_CRITICAL();
+
+    if(model_pending)
+        settings_encode_optimum_start(&model);
+    settings_write();
+}
+
+/*task che aggiorna le variabili globali relative ai comandi impartiti dall'utente.
+  le modifiche alle impostazioni vengono salvate in nvs solo dopo CONFIG_THERMO_SETTINGS_COMMIT_DELAY_MS senza nuovi comandi,
+  per cui una raffica di comandi produce una sola scrittura, al più ogni CONFIG_THERMO_SETTINGS_COMMIT_MAX_DELAY_MS.
+  il salvataggio avviene in questo task, l'unico che modifica la programmazione settimanale, anche per il modello
+  dell'avvio anticipato appreso dal termostato, che così non scrive in flash dal proprio stack*/ 
 
 static void json_decode_global_variables_update_task(void *arg)
 {   
-    cJSON * root = NULL;
+    command_context_t ctx = {.day_selected = -1};
+    json_reader_t reader;
+    json_member_t member;
     char* buffer = NULL;
-    int day_selected = -1;
-    char start_time[9] = {'\0'};
-    char end_time[9] = {'\0'};
+    int slot;
+    bool settings_dirty = false;            //impostazioni modificate non ancora salvate
+    TickType_t settings_dirty_since = 0;    //tick della prima modifica non salvata
 
     for(;;)
     {
-        xQueueReceive(mqtt_data_pointers_queue_handler, &buffer, portMAX_DELAY);
-        
-        root = cJSON_Parse(buffer);     //parsing dei dati in formato json ricevuti e copiati nel buffer dall'event handler mqtt
-        
-        if(root)
-        {  
-            if(cJSON_HasObjectItem(root, "syncRequest")) //richiesta stato nodo online/offline
+        slot = command_pool_receive(&buffer, settings_dirty ? CONFIG_THERMO_SETTINGS_COMMIT_DELAY_MS / portTICK_PERIOD_MS : OPTIMUM_START_SAVE_POLL_TICKS);
+        if(slot < 0)
+        {
+            if(settings_dirty)  //nessun comando durante l'attesa, salvataggio delle modifiche accumulate
             {
-                cJSON *boolean_value = cJSON_GetObjectItem(root, "syncRequest");
-                if(cJSON_IsTrue(boolean_value))
-                    xEventGroupSetBits(global_variable_update_group, NODE_ONLINE_STATUS_BIT_PUBLISHER_TASK);
+                commit_settings();
+                settings_dirty = false;
             }
-
-            else if(cJSON_HasObjectItem(root, "targetTemp") && cJSON_GetObjectItem(root, "targetTemp")->valuedouble >= MIN_TARGET_TEMP && cJSON_GetObjectItem(root, "targetTemp")->valuedouble <= MAX_TARGET_TEMP)     //nuova temperatura target del termostato
+            else if(optimum_start_learned_pending)     //nuovo modello appreso, salvato dopo l'attesa come una modifica
             {
-                target_temp = cJSON_GetObjectItem(root, "targetTemp")->valuedouble;
-                xEventGroupSetBits(global_variable_update_group, TARGET_TEMP_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
+                settings_dirty = true;
+                settings_dirty_since = xTaskGetTickCount();
             }
+            continue;
+        }
 
-            else if(cJSON_HasObjectItem(root, "deltaTemp") && cJSON_GetObjectItem(root, "deltaTemp")->valuedouble >= MIN_DELTA_TEMP && cJSON_GetObjectItem(root, "deltaTemp")->valuedouble <= MAX_DELTA_TEMP)
-            {
-                delta_temp = cJSON_GetObjectItem(root, "deltaTemp")->valuedouble;
-                xEventGroupSetBits(global_variable_update_group, DELTA_TEMP_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
-            }
+        ctx.bits = 0;
+        ctx.weekday_selected = -1;
+        ctx.start_time = NULL;
+        ctx.end_time = NULL;
 
-            else if(cJSON_HasObjectItem(root, "mainSwitch"))    //interruttore generale termostato true->acceso, false->spento
-            {
-                cJSON *boolean_value = cJSON_GetObjectItem(root, "mainSwitch");
-                if(cJSON_IsTrue(boolean_value))
-                    main_switch = true;
-                else
-                    main_switch = false;
+        //lettura dei campi direttamente nello slot del pool, ogni chiave viene eseguita appena letta
+        if(json_reader_init(&reader, buffer))
+        {
+            while(json_reader_next(&reader, &member))
+                dispatch_command(&member, &ctx);
 
-                xEventGroupSetBits(global_variable_update_group, MAIN_SWITCH_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
-            }
+            week_prog_interval_command(&ctx);
+        }
 
-            else if(cJSON_HasObjectItem(root, "progSwitch"))    //interruttore programmazione oraria settimanale abilitata/disabilitata true->abilitata, false->disabilitata
-            {
-                cJSON *boolean_value = cJSON_GetObjectItem(root, "progSwitch");
-                if(cJSON_IsTrue(boolean_value))
-                    prog_switch = true;
-                else
-                    prog_switch = false;
+        metrics_count(METRICS_COMMANDS);
+        if(reader.error)
+        {
+            metrics_count(METRICS_COMMANDS_MALFORMED);
+            ESP_LOGE(TAG, "malformed command");
+        }
 
-                xEventGroupSetBits(global_variable_update_group, PROG_SWITCH_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
-            }
+        if(ctx.bits & WAKE_UP_BIT_THERMO_TASK)
+            command_wake_ms = (uint32_t)(platform_uptime_us() / 1000) | 1;    //mai 0, che indica nessun comando in attesa
+        if(ctx.bits)
+            xEventGroupSetBits(global_variable_update_group, ctx.bits);
 
-            //programmazione settimanale, orario di inizio per un determintato giorno
-            else if(cJSON_HasObjectItem(root, "startTime") && cJSON_HasObjectItem(root, "weekdaySelected") && cJSON_GetObjectItem(root, "weekdaySelected")->valueint >= 0 && cJSON_GetObjectItem(root, "weekdaySelected")->valueint <= 6)
-            {
-                day_selected = cJSON_GetObjectItem(root, "weekdaySelected")->valueint;
-                strncpy(start_time, cJSON_GetObjectItem(root, "startTime")->valuestring, 8);
-                
-            }
+        command_pool_release(slot);   //restituzione dello slot al pool dei comandi
 
-            //programmazione settimanale, orario di fine per il giorno selezionato precedentemente
-            else if(cJSON_HasObjectItem(root, "endTime") && cJSON_HasObjectItem(root, "weekdaySelected") && cJSON_GetObjectItem(root, "weekdaySelected")->valueint >= 0 && cJSON_GetObjectItem(root, "weekdaySelected")->valueint <= 6 && cJSON_GetObjectItem(root, "weekdaySelected")->valueint == day_selected)
-            {
-                strncpy(end_time, cJSON_GetObjectItem(root, "endTime")->valuestring, 8);
-                insert_into_interval_array(week_prog[day_selected], start_time, end_time, TIME_INTERVALS_PER_DAY);
-                day_selected = -1;
-                xEventGroupSetBits(global_variable_update_group, WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
-            }
-
-            //elimina programmazione per un giorno della settimana
-            else if(cJSON_HasObjectItem(root, "weekdayClear") && cJSON_GetObjectItem(root, "weekdayClear")->valueint >= 0 && cJSON_GetObjectItem(root, "weekdayClear")->valueint <= 6)
-            {
-                day_selected = cJSON_GetObjectItem(root, "weekdayClear")->valueint;
-                init_interval_array(week_prog[day_selected], TIME_INTERVALS_PER_DAY);
-                xEventGroupSetBits(global_variable_update_group, WEEK_PROG_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
-            }
-
-            else if (cJSON_HasObjectItem(root, "baseTemp") && cJSON_GetObjectItem(root, "baseTemp")->valuedouble >= MIN_BASE_TEMP && cJSON_GetObjectItem(root, "baseTemp")->valuedouble <= MAX_BASE_TEMP)
-            {
-                base_temp = cJSON_GetObjectItem(root, "baseTemp")->valuedouble;
-                xEventGroupSetBits(global_variable_update_group, BASE_TEMP_UPDATE_BIT_PUBLISHER_TASK | WAKE_UP_BIT_THERMO_TASK);
-            }
-            
-            //richiesta di aggiornamento forzato dello stato da parte dell'app, invio di tutti i valori di stato
-            else if(cJSON_HasObjectItem(root, "updateRequest"))
-            {
-                cJSON *boolean_value = cJSON_GetObjectItem(root, "updateRequest");
-                if(cJSON_IsTrue(boolean_value))
-                    xEventGroupSetBits(global_variable_update_group, UPDATE_REQUEST_BIT_PUBLISHER_TASK);
-            }
+        if(((ctx.bits & PERSISTENT_SETTINGS_BITS) || optimum_start_learned_pending) && !settings_dirty)
+        {
+            settings_dirty = true;
+            settings_dirty_since = xTaskGetTickCount();
+        }
 
-            cJSON_Delete(root);
-            root = NULL;    
+        if(settings_dirty && xTaskGetTickCount() - settings_dirty_since >= CONFIG_THERMO_SETTINGS_COMMIT_MAX_DELAY_MS / portTICK_PERIOD_MS)
+        {
+            commit_settings();  //comandi continui, il salvataggio non viene rimandato oltre il massimo
+            settings_dirty = false;
         }
-        
-        free(buffer);   // deallocazione del buffer creato al ricevimento dei dati
     }
 
     vTaskDelete(NULL);
@@ -596,62 +1422,39 @@ static void json_decode_global_variables_update_task(void *arg)
 
 /*EVENT HANDLERS*/
 
-/*event handler per eventi mqtt*/
+/*event handler per gli eventi del client mqtt della piattaforma*/
 
-static void mqtt_client_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+static void mqtt_client_event_handler(const platform_mqtt_event_t *event)
 {    
-    if(event_id == MQTT_EVENT_CONNECTED)    //connessione al broker riuscita
+    if(event->type == PLATFORM_MQTT_CONNECTED)    //connessione al broker riuscita
     {
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
         xEventGroupSetBits(connection_event_group, MQTT_CONNECTED_BIT);     
     }
-    else if(event_id == MQTT_EVENT_DISCONNECTED)    //connessione al broker non riuscita o persa
+    else if(event->type == PLATFORM_MQTT_DISCONNECTED)    //connessione al broker non riuscita o persa
     {
         xEventGroupSetBits(connection_event_group, MQTT_FAIL_BIT);
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
     }
-    else if (event_id == MQTT_EVENT_DATA)   //dati mqtt per topic sottoscritto
+    else if (event->type == PLATFORM_MQTT_DATA)   //dati mqtt per topic sottoscritto
     {
-        esp_mqtt_event_handle_t event = event_data;
         ESP_LOGI(TAG, "MQTT_EVENT_DATA");
-        char * buffer = (char*)malloc((event->data_len) * sizeof(char) + 1); //allocazione dinamica di un buffer di memoria in base alla lungezza dei dati in ingresso
-        memcpy(buffer, event->data, event->data_len  * sizeof(char)); //copia dei dati in ingesso nel buffer
-        buffer[event->data_len] = '\0';                               //terminatore di stringa nel casoi dati in ingresso non siano null terminated
-        xQueueSend(mqtt_data_pointers_queue_handler, &buffer, portMAX_DELAY);     //il puntantore viene inserito nella queue
+        //copia non bloccante nel pool statico, i messaggi più grandi del buffer del client arrivano in più eventi e vengono ricomposti
+        command_pool_put_fragment(event->data, event->length, event->offset, event->total_length);
 
-        // la free avviene nel task json_decode_global_variables_update_task
+        // lo slot viene restituito dal task json_decode_global_variables_update_task
     }
 }
 
-/*event handler per gli eventi di sistema, wi-fi event e ip event*/
+/*event handler per gli eventi di rete della piattaforma*/
 
-static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+static void network_event_handler(platform_network_event_t event)
 {   
-    static int s_retry_num;
-
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) 
-        esp_wifi_connect();
-
-    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
-    {
-        if (s_retry_num < EXAMPLE_ESP_MAXIMUM_RETRY) 
-        {
-            esp_wifi_connect();
-            s_retry_num++;    
-        } 
-
-        else 
-        {
-            s_retry_num = 0;
-            xEventGroupSetBits(connection_event_group, WIFI_FAIL_BIT);
-        }
-
-    } 
-    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) 
-    {
-        s_retry_num = 0;
+    if (event == PLATFORM_NETWORK_CONNECTED) 
         xEventGroupSetBits(connection_event_group, WIFI_CONNECTED_BIT);
-    }
+
+    else    //ogni disconnessione o tentativo fallito, i nuovi tentativi sono gestiti dal task di riconnessione
+        xEventGroupSetBits(connection_event_group, WIFI_FAIL_BIT);
 }
 
 /* 
@@ -662,7 +1465,18 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
 
 void app_main()
 {   
-    esp_event_loop_create_default();    //creazione dell'event loop di sistema
+    thermo_state_t initial_state = thermo_state_defaults;
+
+    //ripristino delle impostazioni e della programmazione salvate, prima della creazione dei task
+
+    platform_storage_setup();
+    week_prog_setup();
+    if(!settings_restore(&initial_state, &week_prog))
+        ESP_LOGI(TAG, "no saved settings, using defaults");
+    optimum_start_init(&optimum_start_model);
+    if(!settings_restore_optimum_start(&optimum_start_model))
+        ESP_LOGI(TAG, "no saved heating model, optimum start waits for %d heating runs", OPTIMUM_START_MIN_SAMPLES);
+    thermo_state_init(&initial_state);
     
     //creazione delle strutture degli event group
 
@@ -670,118 +1484,71 @@ void app_main()
     reconnection_request_group = xEventGroupCreate();
     global_variable_update_group = xEventGroupCreate();
 
-    mqtt_data_pointers_queue_handler = xQueueCreate(5, sizeof(char*));  //creazione della queue per i dati mqtt
+    metrics_init();         //contatori e istogrammi azzerati
+    command_pool_init();    //creazione del pool statico per i comandi mqtt
+    history_init();         //storico di temperatura e umidità vuoto
+    history_query_queue = xQueueCreate(1, sizeof(history_query_t));
+    telemetry_log_init();   //registro degli eventi offline, attivo fino alla prima connessione
+    reconnect_link_init(&wifi_link, CONFIG_THERMO_RECONNECT_MIN_DELAY_MS, CONFIG_THERMO_RECONNECT_MAX_DELAY_MS);
+    reconnect_link_init(&mqtt_link, CONFIG_THERMO_RECONNECT_MIN_DELAY_MS, CONFIG_THERMO_RECONNECT_MAX_DELAY_MS);
 
-    //setup dell'applicazione
+    prog_transition_timer_handler = xTimerCreate("prog_transition_timer", 1, pdFALSE, NULL, prog_transition_timer_callback);  //timer one-shot per i cambi di stato della programmazione
+#if CONFIG_THERMO_METRICS_INTERVAL_S > 0
+    metrics_timer_handler = xTimerCreate("metrics_timer", CONFIG_THERMO_METRICS_INTERVAL_S * 1000 / portTICK_PERIOD_MS, pdTRUE, NULL, metrics_timer_callback);    //timer periodico dello snapshot delle metriche
+    xTimerStart(metrics_timer_handler, 0);
+#endif
 
-    wifi_setup();
-    sntp_setup();
-    mqtt_client_setup();
-    week_prog_setup();
-    gpio_setup();
-    dht_setup();
-    
-    //creazione dei task
+    //avvio rapido: sensori e termostato partono subito, senza attendere rete e orario
+
+    platform_setup();   //event loop di sistema, relè spento e sensori configurati
+    xTaskCreate(measure_task, "measure_task", 2048, (void*)1, 1, &measure_task_handler);
+    xTaskCreate(thermo_task, "thermo_task", 2048, (void*)1, 1, &thermo_task_handler);
+
+    //avvio della rete in parallelo al controllo, i task di rete esistono già quando arrivano i primi eventi di connessione
 
-    xTaskCreate(measure_task, "measure_task", 2048, (void*)1, 1, NULL);
+    platform_time_sync_setup();
+    mqtt_client_setup();
     xTaskCreate(led_builtin_blinker_task, "led_builtin_blinker_task", configMINIMAL_STACK_SIZE, (void*)1, 1, &led_builtin_blinker_task_handler);
     xTaskCreate(connection_event_manager_task, "connection_event_manager_task", 2048, (void*)1, 2, &connection_event_manager_task_handler);
     xTaskCreate(mqtt_publish_json_task, "mqtt_publish_json_task", 2048, (void*)1, 1, &mqtt_publish_json_task_handler);
     xTaskCreate(try_to_reconnect_task, "try_to_reconnect_task", 2048, (void*)1, 1, &try_to_reconnect_task_handler);   
-    xTaskCreate(json_decode_global_variables_update_task, "json_decode_global_variables_update_task", 2048, (void*)1, 1, json_decode_global_variables_update_task_handler); 
-    xTaskCreate(thermo_task, "thermo_task", 2048, (void*)1, 1, thermo_task_handler);
+    xTaskCreate(json_decode_global_variables_update_task, "json_decode_global_variables_update_task", 2048, (void*)1, 1, &json_decode_global_variables_update_task_handler); 
+
+    //stack mai usato di ogni task, riportato nello snapshot delle metriche
+    metrics_register_task(measure_task_handler, "stackMeasure");
+    metrics_register_task(thermo_task_handler, "stackThermo");
+    metrics_register_task(led_builtin_blinker_task_handler, "stackLed");
+    metrics_register_task(connection_event_manager_task_handler, "stackConnection");
+    metrics_register_task(mqtt_publish_json_task_handler, "stackPublish");
+    metrics_register_task(try_to_reconnect_task_handler, "stackReconnect");
+    metrics_register_task(json_decode_global_variables_update_task_handler, "stackCommands");
+    platform_network_setup(network_event_handler);
 }
 
 /*FUNZIONI LOCALI*/
 
-//configurazione e avvio del wi-fi
-void wifi_setup(void)   
-{
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-   esp_wifi_init(&cfg);
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = EXAMPLE_ESP_WIFI_SSID,
-            .password = EXAMPLE_ESP_WIFI_PASS
-        },
-    };
-
-    if (strlen((char *)wifi_config.sta.password)) 
-    {
-        wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
-    }
-
-    esp_wifi_set_mode(WIFI_MODE_STA);
-    esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config);
-    esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL);
-    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL);
-    tcpip_adapter_init();
-    esp_wifi_start();
-    ESP_LOGI(TAG, "wifi_setup finished.");
-}
-
-//configurazione del servizio sntp e impostazione della timezone locale
-void sntp_setup(void)
-{
-    ESP_LOGI(TAG, "Initializing SNTP");
-    sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    sntp_setservername(0, "pool.ntp.org");
-    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
-    tzset();
-}
-
-//configurazione dei gpio
-void gpio_setup(void)
-{
-    gpio_config_t io_conf;  //struttura per la configurazione dei gpio
-
-    io_conf.intr_type = GPIO_INTR_DISABLE; //disabilita gli interrupt
-    io_conf.mode = GPIO_MODE_OUTPUT;    // output
-    io_conf.pin_bit_mask = LED_BUILTIN_MASK | RELAY_MASK;    //maschera per la selezione dei gpio su cui applicare la conf.
-    io_conf.pull_down_en = 0;   //pull-down disabilitato
-    io_conf.pull_up_en = 0;     //pull-up disabilitato
-
-    gpio_config(&io_conf);      //applica la configurazione ai gpio
-
-    gpio_set_level(LED_BUILTIN, 1); //spegnimento del led builtin attivo basso
-    gpio_set_level(RELAY, 0);
-}
-
-//configurazione del sensore dht
-void dht_setup(void)
-{
-    dht_config_t dht_conf;
-    dht_conf.dht_gpio = DHT_GPIO;
-    dht_conf.dht_type = DHT_22;
-    dht_conf.safe_mode = true;
-
-    dht_config(&dht_conf);
-}
-
 //configurazione del client mqtt
 void mqtt_client_setup(void)
 {   
     char rendered[25];
+    json_writer_t writer;
 
     ESP_LOGI(TAG, "Initializing MQTT");
-    cJSON *root = cJSON_CreateObject(); //messaggio di last will in formato json
-    cJSON_AddFalseToObject(root, "nodeOnline");
-    cJSON_PrintPreallocated(root, rendered, 25, 0);
-    esp_mqtt_client_config_t mqtt_cfg = {
+    json_writer_init(&writer, rendered, sizeof(rendered));  //messaggio di last will in formato json
+    json_writer_add_bool(&writer, "nodeOnline", false);
+    json_writer_finish(&writer);
+    platform_mqtt_config_t mqtt_cfg = {
         .uri = CONFIG_BROKER_URL,
-        .lwt_msg = rendered, 
-        .lwt_topic = MQTT_DATA_PUBLISH_TOPIC, //last will topic
-        .lwt_qos = 0,  
+        .will_message = rendered, 
+        .will_topic = MQTT_DATA_PUBLISH_TOPIC, //last will topic
+        .reconnect_timeout_ms = CONFIG_THERMO_RECONNECT_MAX_DELAY_MS,  //riconnessione automatica del client solo come ultima risorsa, i tentativi sono del task di riconnessione
     };
-    cJSON_Delete(root);
-    mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
-    esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_client_event_handler, mqtt_client);   
+    platform_mqtt_setup(&mqtt_cfg, mqtt_client_event_handler);
 }
 
-//inizializzazione della struttura dati che memorizza la programmazione settimanale
+//inizializzazione della struttura dati che memorizza la programmazione settimanale e del suo mutex
 void week_prog_setup(void)
 {
-    for(int i=0; i<DAYS_PER_WEEK; i++)
-        init_interval_array(week_prog[i], TIME_INTERVALS_PER_DAY);
+    init_week_prog(&week_prog);
+    week_prog_mutex = xSemaphoreCreateMutex();
 }
@@ -0,0 +1,123 @@
+#include <string.h>
+
+#include "esp_system.h"
+
+#include "metrics.h"
+
+/*limiti superiori dei bucket di ogni istogramma, un valore cade nel primo bucket con limite maggiore o uguale*/
+
+static const uint32_t _metrics_bounds[METRICS_HISTOGRAM_COUNT][METRICS_HISTOGRAM_BUCKETS - 1] = {
+    [METRICS_COMMAND_TO_RELAY_MS] = {5, 10, 25, 50, 100, 250, 1000},
+    [METRICS_THERMO_LOOP_US] = {100, 250, 500, 1000, 2500, 5000, 10000},
+};
+
+static const char *_metrics_counter_keys[METRICS_COUNTER_COUNT] = {
+    [METRICS_PUBLISHES] = "publishes",
+    [METRICS_PUBLISH_FAILURES] = "publishFails",
+    [METRICS_COMMANDS] = "commands",
+    [METRICS_COMMANDS_MALFORMED] = "commandsMalformed",
+    [METRICS_DHT_READS] = "dhtReads",
+    [METRICS_DHT_FAILURES] = "dhtFails",
+    [METRICS_RELAY_SWITCHES] = "relaySwitches",
+};
+
+static const char *_metrics_gauge_keys[METRICS_GAUGE_COUNT] = {
+    [METRICS_COMMAND_QUEUE_DEPTH] = "cmdQueue",
+    [METRICS_COMMANDS_DROPPED] = "cmdDropped",
+};
+
+static const char *_metrics_histogram_keys[METRICS_HISTOGRAM_COUNT] = {
+    [METRICS_COMMAND_TO_RELAY_MS] = "cmdRelayMs",
+    [METRICS_THERMO_LOOP_US] = "thermoLoopUs",
+};
+
+static uint32_t _metrics_counters[METRICS_COUNTER_COUNT];
+static uint32_t _metrics_gauges[METRICS_GAUGE_COUNT];
+static uint32_t _metrics_histograms[METRICS_HISTOGRAM_COUNT][METRICS_HISTOGRAM_BUCKETS];
+
+static TaskHandle_t _metrics_tasks[METRICS_MAX_TASKS];
+static const char *_metrics_task_keys[METRICS_MAX_TASKS];
+static int _metrics_tasks_count = 0;
+
+/*azzera tutte le metriche, da chiamare prima della creazione dei task*/
+
+void metrics_init(void)
+{
+    memset(_metrics_counters, 0, sizeof(_metrics_counters));
+    memset(_metrics_gauges, 0, sizeof(_metrics_gauges));
+    memset(_metrics_histograms, 0, sizeof(_metrics_histograms));
+    _metrics_tasks_count = 0;
+}
+
+void metrics_count(metrics_counter_t counter)
+{
+    taskENTER_CRITICAL();
+    _metrics_counters[counter]++;
+    taskEXIT_CRITICAL();
+}
+
+void metrics_gauge_set(metrics_gauge_t gauge, uint32_t value)
+{
+    _metrics_gauges[gauge] = value;     //scrittura di una word, atomica
+}
+
+void metrics_observe(metrics_histogram_t histogram, uint32_t value)
+{
+    int bucket = 0;
+
+    while (bucket < METRICS_HISTOGRAM_BUCKETS - 1 && value > _metrics_bounds[histogram][bucket])
+        bucket++;
+
+    taskENTER_CRITICAL();
+    _metrics_histograms[histogram][bucket]++;
+    taskEXIT_CRITICAL();
+}
+
+/*aggiunge un task di cui riportare lo stack mai usato, key è la chiave json. ritorna false se la tabella è piena*/
+
+bool metrics_register_task(TaskHandle_t task, const char *key)
+{
+    if (task == NULL || _metrics_tasks_count == METRICS_MAX_TASKS)
+        return false;
+
+    _metrics_tasks[_metrics_tasks_count] = task;
+    _metrics_task_keys[_metrics_tasks_count] = key;
+    _metrics_tasks_count++;
+    return true;
+}
+
+/*snapshot compatto delle metriche: heap libero e minimo dall'avvio, stack mai usato da ogni task registrato,
+  contatori, valori istantanei e conteggi dei bucket degli istogrammi. i contatori non vengono azzerati,
+  le variazioni tra due snapshot si ottengono per differenza*/
+
+void metrics_write_snapshot(json_writer_t *writer, uint32_t uptime)
+{
+    uint32_t counters[METRICS_COUNTER_COUNT];
+    uint32_t histograms[METRICS_HISTOGRAM_COUNT][METRICS_HISTOGRAM_BUCKETS];
+
+    taskENTER_CRITICAL();   //copia consistente, la serializzazione avviene fuori dalla sezione critica
+    memcpy(counters, _metrics_counters, sizeof(counters));
+    memcpy(histograms, _metrics_histograms, sizeof(histograms));
+    taskEXIT_CRITICAL();
+
+    json_writer_add_uint(writer, "uptime", uptime);
+    json_writer_add_uint(writer, "heapFree", esp_get_free_heap_size());
+    json_writer_add_uint(writer, "heapMin", esp_get_minimum_free_heap_size());
+
+    for (int i = 0; i < _metrics_tasks_count; i++)     //stack mai usato, in byte
+        json_writer_add_uint(writer, _metrics_task_keys[i], uxTaskGetStackHighWaterMark(_metrics_tasks[i]));
+
+    for (int i = 0; i < METRICS_COUNTER_COUNT; i++)
+        json_writer_add_uint(writer, _metrics_counter_keys[i], counters[i]);
+
+    for (int i = 0; i < METRICS_GAUGE_COUNT; i++)
+        json_writer_add_uint(writer, _metrics_gauge_keys[i], _metrics_gauges[i]);
+
+    for (int i = 0; i < METRICS_HISTOGRAM_COUNT; i++)
+    {
+        json_writer_begin_array(writer, _metrics_histogram_keys[i]);
+        for (int j = 0; j < METRICS_HISTOGRAM_BUCKETS; j++)
+            json_writer_array_add_uint(writer, histograms[i][j]);
+        json_writer_end_array(writer);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "jsonwriter.h"
+
+/*metriche di funzionamento a memoria fissa: contatori crescenti dall'avvio, valori istantanei e istogrammi a bucket fissi.
+  gli aggiornamenti sono un incremento in sezione critica e possono essere chiamati da qualsiasi task*/
+
+#define METRICS_MAX_TASKS 8
+#define METRICS_HISTOGRAM_BUCKETS 8     //l'ultimo bucket raccoglie i valori oltre l'ultimo limite
+
+typedef enum
+{
+    METRICS_PUBLISHES,              //messaggi mqtt pubblicati
+    METRICS_PUBLISH_FAILURES,       //pubblicazioni rifiutate dal client mqtt
+    METRICS_COMMANDS,               //comandi mqtt elaborati
+    METRICS_COMMANDS_MALFORMED,     //comandi con json non valido
+    METRICS_DHT_READS,              //cicli di lettura dei sensori dht
+    METRICS_DHT_FAILURES,           //cicli di lettura senza alcun sensore valido
+    METRICS_RELAY_SWITCHES,         //cambi di stato del relè
+    METRICS_COUNTER_COUNT
+} metrics_counter_t;
+
+typedef enum
+{
+    METRICS_COMMAND_QUEUE_DEPTH,    //comandi in attesa nel pool
+    METRICS_COMMANDS_DROPPED,       //comandi scartati dal pool
+    METRICS_GAUGE_COUNT
+} metrics_gauge_t;
+
+typedef enum
+{
+    METRICS_COMMAND_TO_RELAY_MS,    //dal comando ricevuto alla decisione sul relè, in ms
+    METRICS_THERMO_LOOP_US,         //durata di una valutazione del termostato, in us
+    METRICS_HISTOGRAM_COUNT
+} metrics_histogram_t;
+
+void metrics_init(void);
+void metrics_count(metrics_counter_t counter);
+void metrics_gauge_set(metrics_gauge_t gauge, uint32_t value);
+void metrics_observe(metrics_histogram_t histogram, uint32_t value);
+bool metrics_register_task(TaskHandle_t task, const char *key);
+void metrics_write_snapshot(json_writer_t *writer, uint32_t uptime);
+
+#endif
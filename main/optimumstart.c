@@ -0,0 +1,124 @@
+#include "optimumstart.h"
+
+#define _OPTIMUM_START_DECAY_SHIFT 4
+#define _OPTIMUM_START_MIN_TEMP 0           //temperature medie considerate, 0°C / 40°C
+#define _OPTIMUM_START_MAX_TEMP 400
+#define _OPTIMUM_START_MAX_RATE 600         //velocità massima considerata, 60°C all'ora
+#define _OPTIMUM_START_SECONDS_PER_HOUR 3600
+
+static int32_t _optimum_start_clamp(int32_t value, int32_t min, int32_t max)
+{
+    return value < min ? min : value > max ? max : value;
+}
+
+void optimum_start_init(optimum_start_model_t *model)
+{
+    model->weight = 0;
+    model->sum_temp = 0;
+    model->sum_rate = 0;
+    model->sum_temp_temp = 0;
+    model->sum_temp_rate = 0;
+    model->samples = 0;
+}
+
+void optimum_start_run_init(optimum_start_run_t *run)
+{
+    run->active = false;
+    run->start = 0;
+    run->start_temp = 0;
+}
+
+/*aggiunge un campione alle somme, i campioni precedenti perdono 1/16 del loro peso*/
+
+static void _optimum_start_add(optimum_start_model_t *model, int32_t temp, int32_t rate)
+{
+    model->weight += OPTIMUM_START_SAMPLE_WEIGHT - (model->weight >> _OPTIMUM_START_DECAY_SHIFT);
+    model->sum_temp += OPTIMUM_START_SAMPLE_WEIGHT * temp - (model->sum_temp >> _OPTIMUM_START_DECAY_SHIFT);
+    model->sum_rate += OPTIMUM_START_SAMPLE_WEIGHT * rate - (model->sum_rate >> _OPTIMUM_START_DECAY_SHIFT);
+    model->sum_temp_temp += OPTIMUM_START_SAMPLE_WEIGHT * temp * temp - (model->sum_temp_temp >> _OPTIMUM_START_DECAY_SHIFT);
+    model->sum_temp_rate += OPTIMUM_START_SAMPLE_WEIGHT * temp * rate - (model->sum_temp_rate >> _OPTIMUM_START_DECAY_SHIFT);
+    if (model->samples < UINT16_MAX)
+        model->samples++;
+}
+
+/*da chiamare ad ogni valutazione con lo stato del relè appena deciso: all'accensione registra istante e temperatura,
+  allo spegnimento le accensioni lunghe almeno min_run_s diventano un campione. con valid false (sensore non disponibile)
+  l'accensione in corso viene scartata. ritorna true se il modello è stato aggiornato*/
+
+bool optimum_start_observe(optimum_start_model_t *model, optimum_start_run_t *run, uint32_t now, int16_t temp, bool heating, bool valid, uint32_t min_run_s)
+{
+    uint32_t duration;
+    int32_t rate;
+
+    if (!valid)
+    {
+        run->active = false;
+        return false;
+    }
+
+    if (heating && !run->active)
+    {
+        run->active = true;
+        run->start = now;
+        run->start_temp = temp;
+        return false;
+    }
+
+    if (heating || !run->active)
+        return false;
+
+    run->active = false;
+    duration = now - run->start;
+    if (duration < min_run_s || duration == 0)
+        return false;
+
+    rate = (int32_t)((int64_t)(temp - run->start_temp) * _OPTIMUM_START_SECONDS_PER_HOUR / (int64_t)duration);
+    _optimum_start_add(model,
+                       _optimum_start_clamp((run->start_temp + temp) / 2, _OPTIMUM_START_MIN_TEMP, _OPTIMUM_START_MAX_TEMP),
+                       _optimum_start_clamp(rate, 0, _OPTIMUM_START_MAX_RATE));
+    return true;
+}
+
+/*velocità di riscaldamento prevista alla temperatura temp, 0 se il modello non ha ancora abbastanza campioni.
+  con temperature medie troppo simili tra i campioni la pendenza non è stimabile e si usa la velocità media*/
+
+int32_t optimum_start_rate(const optimum_start_model_t *model, int16_t temp)
+{
+    int64_t w = model->weight;
+    int64_t numerator;
+    int64_t denominator;
+    int64_t x;
+
+    if (model->samples < OPTIMUM_START_MIN_SAMPLES || w <= 0)
+        return 0;
+
+    x = _optimum_start_clamp(temp, _OPTIMUM_START_MIN_TEMP, _OPTIMUM_START_MAX_TEMP);
+    numerator = w * model->sum_temp_rate - (int64_t)model->sum_temp * model->sum_rate;
+    denominator = w * model->sum_temp_temp - (int64_t)model->sum_temp * model->sum_temp;
+
+    //varianza delle temperature sotto 0.5°C, pendenza non affidabile
+    if (denominator < w * w * 25)
+        return model->sum_rate / w;
+
+    //retta di regressione: media delle velocità più pendenza per la distanza dalla media delle temperature
+    return (int32_t)((model->sum_rate * denominator + numerator * (w * x - model->sum_temp)) / (w * denominator));
+}
+
+/*anticipo necessario per portare la stanza da current a target, con la velocità prevista a metà del percorso.
+  0 se la stanza è già in temperatura o il modello non è pronto, al più max_lead_s*/
+
+uint32_t optimum_start_lead_s(const optimum_start_model_t *model, int16_t current, int16_t target, uint32_t max_lead_s)
+{
+    int32_t rate;
+    uint64_t lead;
+
+    if (current >= target || model->samples < OPTIMUM_START_MIN_SAMPLES)
+        return 0;
+
+    rate = optimum_start_rate(model, (current + target) / 2);
+    if (rate < OPTIMUM_START_MIN_RATE)
+        return max_lead_s;
+
+    lead = (uint64_t)(target - current) * _OPTIMUM_START_SECONDS_PER_HOUR / rate;
+    return lead < max_lead_s ? (uint32_t)lead : max_lead_s;
+}
@@ -0,0 +1,43 @@
+#ifndef _OPTIMUMSTART_H
+#define _OPTIMUMSTART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*avvio anticipato del riscaldamento (optimum start): la velocità di riscaldamento della stanza viene appresa dalle
+  accensioni del relè come retta in funzione della temperatura interna, che in assenza di un sensore esterno rappresenta
+  la differenza con l'esterno. temperature in decimi, velocità in decimi di grado all'ora, istanti in secondi*/
+
+#define OPTIMUM_START_SAMPLE_WEIGHT 16      //peso di un nuovo campione, le somme decadono di 1/16 ad ogni campione
+#define OPTIMUM_START_MIN_SAMPLES 3         //campioni necessari prima di anticipare l'accensione
+#define OPTIMUM_START_MIN_RATE 5            //velocità minima prevista, 0.5°C all'ora
+
+/*modello compatto salvato con le impostazioni: somme pesate per la regressione lineare della velocità
+  sulla temperatura media di ogni accensione*/
+
+typedef struct
+{
+    int32_t weight;
+    int32_t sum_temp;
+    int32_t sum_rate;
+    int32_t sum_temp_temp;
+    int32_t sum_temp_rate;
+    uint16_t samples;               //campioni appresi, saturato
+} optimum_start_model_t;
+
+/*accensione in corso del relè*/
+
+typedef struct
+{
+    bool active;
+    uint32_t start;
+    int16_t start_temp;
+} optimum_start_run_t;
+
+void optimum_start_init(optimum_start_model_t *model);
+void optimum_start_run_init(optimum_start_run_t *run);
+bool optimum_start_observe(optimum_start_model_t *model, optimum_start_run_t *run, uint32_t now, int16_t temp, bool heating, bool valid, uint32_t min_run_s);
+int32_t optimum_start_rate(const optimum_start_model_t *model, int16_t temp);
+uint32_t optimum_start_lead_s(const optimum_start_model_t *model, int16_t current, int16_t target, uint32_t max_lead_s);
+
+#endif
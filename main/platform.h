@@ -0,0 +1,81 @@
+#ifndef _PLATFORM_H
+#define _PLATFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "sensorreading.h"
+
+/*interfaccia verso l'hardware, la rete e l'orologio usata dai task dell'applicazione: relè, led, sensori di temperatura,
+  memoria non volatile, wi-fi, client mqtt, sincronizzazione dell'orario e numeri casuali. main.c dipende solo da queste
+  funzioni, da freertos e dal log; il salvataggio delle impostazioni (settings.c) usa direttamente nvs e le metriche
+  (metrics.c) leggono l'heap dall'sdk.
+  implementazioni: platform_esp8266.c per il firmware, platform_linux.c per lo stesso firmware su linux con il port
+  posix di freertos e un broker reale (linux/), platform_posix.c per test e simulazioni su host (relè simulato,
+  sensori scriptati, broker simulato e orologio virtuale)*/
+
+/*eventi di rete notificati dalla piattaforma, da qualsiasi contesto: il gestore non deve bloccare*/
+
+typedef enum
+{
+    PLATFORM_NETWORK_CONNECTED,         //collegamento stabilito e indirizzo ip ottenuto
+    PLATFORM_NETWORK_DISCONNECTED       //collegamento perso o tentativo di connessione fallito
+} platform_network_event_t;
+
+typedef void (*platform_network_handler_t)(platform_network_event_t event);
+
+/*eventi del client mqtt, notificati dal contesto del client: il gestore non deve bloccare. un messaggio ricevuto più
+  grande del buffer del client arriva in più eventi PLATFORM_MQTT_DATA, ognuno con length byte a partire da offset
+  su total_length*/
+
+typedef enum
+{
+    PLATFORM_MQTT_CONNECTED,            //connessione al broker stabilita
+    PLATFORM_MQTT_DISCONNECTED,         //connessione al broker persa o tentativo di connessione fallito
+    PLATFORM_MQTT_DATA                  //messaggio su un topic sottoscritto
+} platform_mqtt_event_type_t;
+
+typedef struct
+{
+    platform_mqtt_event_type_t type;
+    const char *data;
+    int length;
+    int offset;
+    int total_length;
+} platform_mqtt_event_t;
+
+typedef void (*platform_mqtt_handler_t)(const platform_mqtt_event_t *event);
+
+typedef struct
+{
+    const char *uri;                    //mqtt://host[:porta]
+    const char *will_topic;             //messaggio di last will, pubblicato dal broker alla disconnessione
+    const char *will_message;
+    uint32_t reconnect_timeout_ms;      //riconnessione automatica del client, solo come ultima risorsa
+} platform_mqtt_config_t;
+
+void platform_setup(void);
+void platform_relay_set(bool on);
+void platform_led_set(bool on);
+int platform_sensors_count(void);
+int platform_sensors_read(dht_reading_t *readings);
+int64_t platform_uptime_us(void);
+time_t platform_time(void);
+
+void platform_storage_setup(void);
+void platform_network_setup(platform_network_handler_t handler);
+void platform_network_connect(void);
+void platform_time_sync_setup(void);
+void platform_time_sync_start(void);
+void platform_time_sync_stop(void);
+uint32_t platform_random(void);
+
+void platform_mqtt_setup(const platform_mqtt_config_t *config, platform_mqtt_handler_t handler);
+void platform_mqtt_start(void);
+void platform_mqtt_stop(void);
+void platform_mqtt_reconnect(void);
+int platform_mqtt_subscribe(const char *topic);
+int platform_mqtt_publish(const char *topic, const char *data, int length);     //qos 0, ritorna un valore negativo se fallita
+
+#endif
@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "driver/gpio.h"
+#include "lwip/apps/sntp.h"
+#include "nvs_flash.h"
+#include "mqtt_client.h"
+
+#include "dht.h"
+#include "platform.h"
+
+/*definizione macro per wifi*/
+
+#define EXAMPLE_ESP_WIFI_SSID      "sistembed"
+#define EXAMPLE_ESP_WIFI_PASS      "lastessa"
+
+/*definizione dei gpio*/
+
+#define LED_BUILTIN GPIO_NUM_2
+#define LED_BUILTIN_MASK GPIO_Pin_2
+
+#define RELAY GPIO_NUM_4
+#define RELAY_MASK GPIO_Pin_4
+
+#define DHT_GPIO GPIO_NUM_5
+
+/*sensori dht, per ambienti ampi possono essere aggiunti altri sensori su gpio diversi (max DHT_MAX_SENSORS)*/
+
+static const dht_config_t dht_sensors_config[] = {
+    {.dht_type = DHT_22, .dht_gpio = DHT_GPIO, .safe_mode = true},
+};
+
+static dht_handle_t dht_handles[DHT_MAX_SENSORS];
+static int dht_sensors_count = 0;
+
+static platform_network_handler_t network_handler = NULL;
+
+static esp_mqtt_client_handle_t mqtt_client;
+static platform_mqtt_handler_t mqtt_handler = NULL;
+
+//creazione dell'event loop di sistema, configurazione dei gpio di led e relè, entrambi spenti, e dei sensori dht
+void platform_setup(void)
+{
+    gpio_config_t io_conf;  //struttura per la configurazione dei gpio
+
+    esp_event_loop_create_default();    //usato da wi-fi e client mqtt, creato prima del loro avvio
+
+    io_conf.intr_type = GPIO_INTR_DISABLE; //disabilita gli interrupt
+    io_conf.mode = GPIO_MODE_OUTPUT;    // output
+    io_conf.pin_bit_mask = LED_BUILTIN_MASK | RELAY_MASK;    //maschera per la selezione dei gpio su cui applicare la conf.
+    io_conf.pull_down_en = 0;   //pull-down disabilitato
+    io_conf.pull_up_en = 0;     //pull-up disabilitato
+
+    gpio_config(&io_conf);      //applica la configurazione ai gpio
+
+    gpio_set_level(LED_BUILTIN, 1); //spegnimento del led builtin attivo basso
+    gpio_set_level(RELAY, 0);
+
+    for(int i = 0; i < sizeof(dht_sensors_config) / sizeof(dht_sensors_config[0]); i++)
+    {
+        if(dht_config(&dht_sensors_config[i], &dht_handles[dht_sensors_count]) == ESP_OK)
+            dht_sensors_count++;
+    }
+}
+
+void platform_relay_set(bool on)
+{
+    gpio_set_level(RELAY, on);
+}
+
+void platform_led_set(bool on)
+{
+    gpio_set_level(LED_BUILTIN, !on);   //led builtin attivo basso
+}
+
+//numero di sensori configurati correttamente
+int platform_sensors_count(void)
+{
+    return dht_sensors_count;
+}
+
+//lettura di tutti i sensori, una misura per sensore in readings. ritorna il numero di misure riuscite
+int platform_sensors_read(dht_reading_t *readings)
+{
+    return dht_measure_group(dht_handles, dht_sensors_count, readings);
+}
+
+//tempo monotono dall'avvio in microsecondi
+int64_t platform_uptime_us(void)
+{
+    return esp_timer_get_time();
+}
+
+//orario di sistema in secondi dall'epoch, valido dopo la sincronizzazione sntp
+time_t platform_time(void)
+{
+    return time(NULL);
+}
+
+//inizializzazione della partizione nvs, usata dal wi-fi e per il salvataggio delle impostazioni
+void platform_storage_setup(void)
+{
+    if(nvs_flash_init() == ESP_ERR_NVS_NO_FREE_PAGES)   //partizione piena o di un formato precedente, viene cancellata
+    {
+        nvs_flash_erase();
+        nvs_flash_init();
+    }
+}
+
+/*event handler per gli eventi di sistema, wi-fi event e ip event, tradotti negli eventi di rete della piattaforma*/
+
+static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
+        esp_wifi_connect();
+
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)   //ogni disconnessione o tentativo fallito, i nuovi tentativi sono dell'applicazione
+        network_handler(PLATFORM_NETWORK_DISCONNECTED);
+
+    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
+        network_handler(PLATFORM_NETWORK_CONNECTED);
+}
+
+//configurazione e avvio del wi-fi, il primo tentativo di connessione parte all'avvio della stazione
+void platform_network_setup(platform_network_handler_t handler)
+{
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    wifi_config_t wifi_config = {
+        .sta = {
+            .ssid = EXAMPLE_ESP_WIFI_SSID,
+            .password = EXAMPLE_ESP_WIFI_PASS
+        },
+    };
+
+    network_handler = handler;
+    esp_wifi_init(&cfg);
+
+    if (strlen((char *)wifi_config.sta.password))
+    {
+        wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    }
+
+    esp_wifi_set_mode(WIFI_MODE_STA);
+    esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config);
+    esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &wifi_event_handler, NULL);
+    tcpip_adapter_init();
+    esp_wifi_start();
+}
+
+//nuovo tentativo di connessione all'access point, l'esito arriva come evento di rete
+void platform_network_connect(void)
+{
+    esp_wifi_connect();
+}
+
+//configurazione del servizio sntp e impostazione della timezone locale
+void platform_time_sync_setup(void)
+{
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_setservername(0, "pool.ntp.org");
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+}
+
+void platform_time_sync_start(void)
+{
+    sntp_init();
+}
+
+void platform_time_sync_stop(void)
+{
+    sntp_stop();
+}
+
+//numero casuale dal generatore hardware
+uint32_t platform_random(void)
+{
+    return esp_random();
+}
+
+/*event handler del client mqtt, tradotto negli eventi mqtt della piattaforma*/
+
+static void mqtt_client_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_mqtt_event_handle_t event = event_data;
+    platform_mqtt_event_t mqtt_event = {0};
+
+    if (event_id == MQTT_EVENT_CONNECTED)
+        mqtt_event.type = PLATFORM_MQTT_CONNECTED;
+
+    else if (event_id == MQTT_EVENT_DISCONNECTED)
+        mqtt_event.type = PLATFORM_MQTT_DISCONNECTED;
+
+    else if (event_id == MQTT_EVENT_DATA)   //i messaggi più grandi del buffer del client arrivano in più eventi
+    {
+        mqtt_event.type = PLATFORM_MQTT_DATA;
+        mqtt_event.data = event->data;
+        mqtt_event.length = event->data_len;
+        mqtt_event.offset = event->current_data_offset;
+        mqtt_event.total_length = event->total_data_len;
+    }
+
+    else
+        return;
+
+    mqtt_handler(&mqtt_event);
+}
+
+//configurazione del client mqtt, la connessione parte con platform_mqtt_start
+void platform_mqtt_setup(const platform_mqtt_config_t *config, platform_mqtt_handler_t handler)
+{
+    esp_mqtt_client_config_t mqtt_cfg = {
+        .uri = config->uri,
+        .lwt_msg = config->will_message,
+        .lwt_topic = config->will_topic,
+        .lwt_qos = 0,
+        .reconnect_timeout_ms = config->reconnect_timeout_ms,
+    };
+
+    mqtt_handler = handler;
+    mqtt_client = esp_mqtt_client_init(&mqtt_cfg);
+    esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_client_event_handler, mqtt_client);
+}
+
+void platform_mqtt_start(void)
+{
+    esp_mqtt_client_start(mqtt_client);
+}
+
+void platform_mqtt_stop(void)
+{
+    esp_mqtt_client_stop(mqtt_client);
+}
+
+void platform_mqtt_reconnect(void)
+{
+    esp_mqtt_client_reconnect(mqtt_client);
+}
+
+int platform_mqtt_subscribe(const char *topic)
+{
+    return esp_mqtt_client_subscribe(mqtt_client, topic, 0);
+}
+
+int platform_mqtt_publish(const char *topic, const char *data, int length)
+{
+    return esp_mqtt_client_publish(mqtt_client, topic, data, length, 0, 0);
+}
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <mosquitto.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+
+#include "platform.h"
+
+/*implementazione linux dell'interfaccia della piattaforma, per eseguire il firmware sul port posix di freertos
+  contro un broker mqtt reale (linux/): relè e led scritti nel log, sensore letto da file, rete sempre disponibile,
+  orario di sistema e client mqtt libmosquitto. non fa parte del firmware, esclusa dalla compilazione in component.mk*/
+
+#define SENSOR_FILE_ENV "THERMO_SENSOR_FILE"    //file con "temperatura umidità" in gradi e percentuale, riletto ad ogni misura
+#define SENSOR_DEFAULT_TEMP 200
+#define SENSOR_DEFAULT_HUMI 500
+
+#define MQTT_TASK_STACK 8192
+#define MQTT_LOOP_PERIOD_MS 10
+#define MQTT_KEEPALIVE_S 30
+
+static const char *TAG = "PLATFORM: ";
+
+static platform_network_handler_t network_handler = NULL;
+
+static struct mosquitto *mqtt_client;
+static SemaphoreHandle_t mqtt_mutex;    //libmosquitto non è usata in modalità threaded, ogni chiamata è protetta dal mutex
+static platform_mqtt_handler_t mqtt_handler = NULL;
+static char mqtt_host[128];
+static int mqtt_port = 1883;
+static uint32_t mqtt_reconnect_timeout_ms;
+static bool mqtt_started = false;
+static bool mqtt_connected = false;
+static bool mqtt_reconnect_requested = false;
+static TickType_t mqtt_last_attempt;
+
+void platform_setup(void)
+{
+    srandom((unsigned)time(NULL) ^ (unsigned)getpid());
+    ESP_LOGI(TAG, "relay off, led off");
+}
+
+void platform_relay_set(bool on)
+{
+    ESP_LOGI(TAG, "relay %s", on ? "on" : "off");
+}
+
+void platform_led_set(bool on)
+{
+    ESP_LOGD(TAG, "led %s", on ? "on" : "off");
+}
+
+int platform_sensors_count(void)
+{
+    return 1;
+}
+
+//lettura del sensore dal file indicato in THERMO_SENSOR_FILE, valori fissi se la variabile non è impostata
+int platform_sensors_read(dht_reading_t *readings)
+{
+    const char *path = getenv(SENSOR_FILE_ENV);
+    FILE *file;
+    float temp, humi;
+
+    readings[0].temp = SENSOR_DEFAULT_TEMP;
+    readings[0].humi = SENSOR_DEFAULT_HUMI;
+    readings[0].ok = true;
+
+    if (!path)
+        return 1;
+
+    file = fopen(path, "r");
+    readings[0].ok = file && fscanf(file, "%f %f", &temp, &humi) == 2;
+    if (file)
+        fclose(file);
+
+    if (!readings[0].ok)
+        return 0;
+
+    readings[0].temp = (int16_t)(temp * 10 + (temp < 0 ? -0.5f : 0.5f));
+    readings[0].humi = (int16_t)(humi * 10 + 0.5f);
+    return 1;
+}
+
+int64_t platform_uptime_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+time_t platform_time(void)
+{
+    return time(NULL);
+}
+
+//nvs su file (linux/nvs_file.c), cartella in THERMO_NVS_DIR
+void platform_storage_setup(void)
+{
+    nvs_flash_init();
+}
+
+/*la rete dell'host è considerata sempre disponibile, ogni tentativo di connessione riesce subito*/
+
+void platform_network_setup(platform_network_handler_t handler)
+{
+    network_handler = handler;
+    network_handler(PLATFORM_NETWORK_CONNECTED);
+}
+
+void platform_network_connect(void)
+{
+    network_handler(PLATFORM_NETWORK_CONNECTED);
+}
+
+//l'orario dell'host è già sincronizzato, resta solo la timezone locale
+void platform_time_sync_setup(void)
+{
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+}
+
+void platform_time_sync_start(void)
+{
+}
+
+void platform_time_sync_stop(void)
+{
+}
+
+uint32_t platform_random(void)
+{
+    return ((uint32_t)random() << 16) ^ (uint32_t)random();
+}
+
+/*callback di libmosquitto, chiamate da mosquitto_loop nel task del client con il mutex preso*/
+
+static void mqtt_on_connect(struct mosquitto *mosq, void *obj, int rc)
+{
+    platform_mqtt_event_t event = {.type = rc == 0 ? PLATFORM_MQTT_CONNECTED : PLATFORM_MQTT_DISCONNECTED};
+
+    mqtt_connected = rc == 0;
+    mqtt_handler(&event);
+}
+
+static void mqtt_on_disconnect(struct mosquitto *mosq, void *obj, int rc)
+{
+    platform_mqtt_event_t event = {.type = PLATFORM_MQTT_DISCONNECTED};
+
+    mqtt_connected = false;
+    mqtt_handler(&event);
+}
+
+//libmosquitto consegna i messaggi interi, in un solo evento
+static void mqtt_on_message(struct mosquitto *mosq, void *obj, const struct mosquitto_message *message)
+{
+    platform_mqtt_event_t event = {
+        .type = PLATFORM_MQTT_DATA,
+        .data = message->payload,
+        .length = message->payloadlen,
+        .offset = 0,
+        .total_length = message->payloadlen,
+    };
+
+    mqtt_handler(&event);
+}
+
+//tentativo di connessione non bloccante oltre la risoluzione dell'host, l'esito arriva da mqtt_on_connect
+static void mqtt_connect(void)
+{
+    platform_mqtt_event_t event = {.type = PLATFORM_MQTT_DISCONNECTED};
+
+    mqtt_last_attempt = xTaskGetTickCount();
+    mqtt_reconnect_requested = false;
+
+    if (mosquitto_connect(mqtt_client, mqtt_host, mqtt_port, MQTT_KEEPALIVE_S) != MOSQ_ERR_SUCCESS)
+        mqtt_handler(&event);
+}
+
+/*task del client: gestione del socket, connessione su richiesta dell'applicazione e riconnessione automatica
+  dopo reconnect_timeout_ms come ultima risorsa, come il client dell'sdk*/
+
+static void mqtt_task(void *arg)
+{
+    while (1)
+    {
+        xSemaphoreTake(mqtt_mutex, portMAX_DELAY);
+
+        if (mqtt_started && !mqtt_connected && (mqtt_reconnect_requested || xTaskGetTickCount() - mqtt_last_attempt >= mqtt_reconnect_timeout_ms / portTICK_PERIOD_MS))
+            mqtt_connect();
+
+        if (mqtt_started)
+            mosquitto_loop(mqtt_client, 0, 1);
+
+        xSemaphoreGive(mqtt_mutex);
+        vTaskDelay(MQTT_LOOP_PERIOD_MS / portTICK_PERIOD_MS);
+    }
+}
+
+//configurazione del client mqtt, la connessione parte con platform_mqtt_start. uri nella forma mqtt://host[:porta]
+void platform_mqtt_setup(const platform_mqtt_config_t *config, platform_mqtt_handler_t handler)
+{
+    const char *host = strncmp(config->uri, "mqtt://", 7) == 0 ? config->uri + 7 : config->uri;
+    char *port;
+
+    snprintf(mqtt_host, sizeof(mqtt_host), "%s", host);
+    port = strchr(mqtt_host, ':');
+    if (port)
+    {
+        *port = '\0';
+        mqtt_port = atoi(port + 1);
+    }
+
+    mqtt_handler = handler;
+    mqtt_reconnect_timeout_ms = config->reconnect_timeout_ms;
+    mqtt_mutex = xSemaphoreCreateMutex();
+
+    mosquitto_lib_init();
+    mqtt_client = mosquitto_new(NULL, true, NULL);
+    mosquitto_will_set(mqtt_client, config->will_topic, strlen(config->will_message), config->will_message, 0, false);
+    mosquitto_connect_callback_set(mqtt_client, mqtt_on_connect);
+    mosquitto_disconnect_callback_set(mqtt_client, mqtt_on_disconnect);
+    mosquitto_message_callback_set(mqtt_client, mqtt_on_message);
+
+    xTaskCreate(mqtt_task, "mqtt_task", MQTT_TASK_STACK, NULL, 2, NULL);
+}
+
+void platform_mqtt_start(void)
+{
+    xSemaphoreTake(mqtt_mutex, portMAX_DELAY);
+    mqtt_started = true;
+    mqtt_reconnect_requested = true;
+    xSemaphoreGive(mqtt_mutex);
+}
+
+void platform_mqtt_stop(void)
+{
+    xSemaphoreTake(mqtt_mutex, portMAX_DELAY);
+    mqtt_started = false;
+    mqtt_connected = false;
+    mosquitto_disconnect(mqtt_client);
+    xSemaphoreGive(mqtt_mutex);
+}
+
+void platform_mqtt_reconnect(void)
+{
+    xSemaphoreTake(mqtt_mutex, portMAX_DELAY);
+    mqtt_reconnect_requested = true;
+    xSemaphoreGive(mqtt_mutex);
+}
+
+int platform_mqtt_subscribe(const char *topic)
+{
+    int mid = -1;
+
+    xSemaphoreTake(mqtt_mutex, portMAX_DELAY);
+    if (mosquitto_subscribe(mqtt_client, &mid, topic, 0) != MOSQ_ERR_SUCCESS)
+        mid = -1;
+    xSemaphoreGive(mqtt_mutex);
+    return mid;
+}
+
+int platform_mqtt_publish(const char *topic, const char *data, int length)
+{
+    int mid = -1;
+
+    xSemaphoreTake(mqtt_mutex, portMAX_DELAY);
+    if (mosquitto_publish(mqtt_client, &mid, topic, length, data, 0, false) != MOSQ_ERR_SUCCESS)
+        mid = -1;
+    xSemaphoreGive(mqtt_mutex);
+    return mid;
+}
@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "platform_posix.h"
+
+/*implementazione su host dell'interfaccia della piattaforma, per test e simulazioni: nessun hardware, il tempo avanza
+  solo con platform_posix_advance_us. non fa parte del firmware, esclusa dalla compilazione in component.mk*/
+
+typedef struct
+{
+    time_t epoch;                   //orario di sistema all'istante di reset
+    int64_t uptime_us;
+    bool relay;
+    bool led;
+    uint32_t relay_switches;
+    int sensors_count;
+    dht_reading_t sensors[DHT_MAX_SENSORS];
+    platform_network_handler_t network_handler;
+    bool network_up;
+    platform_mqtt_handler_t mqtt_handler;
+    bool mqtt_started;
+    bool mqtt_connected;
+    uint32_t mqtt_published;
+    char mqtt_last_topic[PLATFORM_POSIX_MQTT_TOPIC_SIZE];
+    char mqtt_last_message[PLATFORM_POSIX_MQTT_MESSAGE_SIZE];
+    bool time_sync_running;
+    uint32_t random_state;
+} _platform_posix_t;
+
+static __thread _platform_posix_t _platform = {.sensors_count = 1, .sensors = {{.ok = true}}, .network_up = true, .random_state = 0x2545F491};
+
+/*riporta la piattaforma del thread corrente all'avvio: orologio a epoch, relè e led spenti, un sensore valido a 0°C,
+  rete disponibile ma non ancora avviata*/
+
+void platform_posix_reset(time_t epoch)
+{
+    uint32_t random_state = _platform.random_state;
+
+    memset(&_platform, 0, sizeof(_platform));
+    _platform.epoch = epoch;
+    _platform.sensors_count = 1;
+    _platform.sensors[0].ok = true;
+    _platform.network_up = true;
+    _platform.random_state = random_state;
+}
+
+void platform_posix_advance_us(int64_t us)
+{
+    if (us > 0)
+        _platform.uptime_us += us;
+}
+
+void platform_posix_set_sensors_count(int count)
+{
+    if (count >= 0 && count <= DHT_MAX_SENSORS)
+        _platform.sensors_count = count;
+}
+
+void platform_posix_set_sensor(int index, int16_t temp, int16_t humi, bool ok)
+{
+    if (index < 0 || index >= DHT_MAX_SENSORS)
+        return;
+
+    _platform.sensors[index].temp = temp;
+    _platform.sensors[index].humi = humi;
+    _platform.sensors[index].ok = ok;
+}
+
+static void _platform_posix_mqtt_event(platform_mqtt_event_type_t type)
+{
+    platform_mqtt_event_t event = {.type = type};
+
+    if (_platform.mqtt_handler)
+        _platform.mqtt_handler(&event);
+}
+
+/*collegamento di rete simulato: la caduta viene notificata subito al gestore, insieme alla perdita del broker,
+  il ritorno solo al successivo tentativo di connessione come avviene con il wi-fi reale*/
+
+void platform_posix_set_network(bool up)
+{
+    bool was_up = _platform.network_up;
+
+    _platform.network_up = up;
+    if (was_up && !up && _platform.network_handler)
+        _platform.network_handler(PLATFORM_NETWORK_DISCONNECTED);
+    if (!up && _platform.mqtt_connected)
+    {
+        _platform.mqtt_connected = false;
+        _platform_posix_mqtt_event(PLATFORM_MQTT_DISCONNECTED);
+    }
+}
+
+/*messaggio dal broker simulato, consegnato in un solo frammento se il client è connesso*/
+
+void platform_posix_mqtt_receive(const char *data, int length)
+{
+    platform_mqtt_event_t event = {.type = PLATFORM_MQTT_DATA, .data = data, .length = length, .offset = 0, .total_length = length};
+
+    if (_platform.mqtt_connected && _platform.mqtt_handler)
+        _platform.mqtt_handler(&event);
+}
+
+uint32_t platform_posix_mqtt_published(void)
+{
+    return _platform.mqtt_published;
+}
+
+/*topic e contenuto dell'ultimo messaggio pubblicato, troncati alla dimensione dei buffer*/
+
+const char *platform_posix_mqtt_last_topic(void)
+{
+    return _platform.mqtt_last_topic;
+}
+
+const char *platform_posix_mqtt_last_message(void)
+{
+    return _platform.mqtt_last_message;
+}
+
+void platform_posix_seed_random(uint32_t seed)
+{
+    _platform.random_state = seed ? seed : 1;   //lo xorshift non esce dallo stato nullo
+}
+
+bool platform_posix_relay(void)
+{
+    return _platform.relay;
+}
+
+uint32_t platform_posix_relay_switches(void)
+{
+    return _platform.relay_switches;
+}
+
+bool platform_posix_led(void)
+{
+    return _platform.led;
+}
+
+bool platform_posix_time_sync_running(void)
+{
+    return _platform.time_sync_running;
+}
+
+/*interfaccia della piattaforma*/
+
+void platform_setup(void)
+{
+    _platform.relay = false;
+    _platform.led = false;
+}
+
+void platform_relay_set(bool on)
+{
+    if (on != _platform.relay)
+        _platform.relay_switches++;
+    _platform.relay = on;
+}
+
+void platform_led_set(bool on)
+{
+    _platform.led = on;
+}
+
+int platform_sensors_count(void)
+{
+    return _platform.sensors_count;
+}
+
+int platform_sensors_read(dht_reading_t *readings)
+{
+    int read = 0;
+
+    for (int i = 0; i < _platform.sensors_count; i++)
+    {
+        readings[i] = _platform.sensors[i];
+        read += readings[i].ok;
+    }
+
+    return read;
+}
+
+int64_t platform_uptime_us(void)
+{
+    return _platform.uptime_us;
+}
+
+time_t platform_time(void)
+{
+    return _platform.epoch + (time_t)(_platform.uptime_us / 1000000);
+}
+
+void platform_storage_setup(void)
+{
+}
+
+void platform_network_setup(platform_network_handler_t handler)
+{
+    _platform.network_handler = handler;
+    platform_network_connect();
+}
+
+void platform_network_connect(void)
+{
+    if (_platform.network_handler)
+        _platform.network_handler(_platform.network_up ? PLATFORM_NETWORK_CONNECTED : PLATFORM_NETWORK_DISCONNECTED);
+}
+
+void platform_time_sync_setup(void)
+{
+}
+
+void platform_time_sync_start(void)
+{
+    _platform.time_sync_running = true;
+}
+
+void platform_time_sync_stop(void)
+{
+    _platform.time_sync_running = false;
+}
+
+uint32_t platform_random(void)
+{
+    _platform.random_state ^= _platform.random_state << 13;
+    _platform.random_state ^= _platform.random_state >> 17;
+    _platform.random_state ^= _platform.random_state << 5;
+    return _platform.random_state;
+}
+
+void platform_mqtt_setup(const platform_mqtt_config_t *config, platform_mqtt_handler_t handler)
+{
+    _platform.mqtt_handler = handler;
+}
+
+/*il broker simulato è raggiungibile quando la rete è disponibile, l'esito di ogni tentativo arriva come evento*/
+
+void platform_mqtt_start(void)
+{
+    _platform.mqtt_started = true;
+    platform_mqtt_reconnect();
+}
+
+void platform_mqtt_stop(void)
+{
+    _platform.mqtt_started = false;
+    _platform.mqtt_connected = false;
+}
+
+void platform_mqtt_reconnect(void)
+{
+    if (!_platform.mqtt_started || _platform.mqtt_connected)
+        return;
+
+    _platform.mqtt_connected = _platform.network_up;
+    _platform_posix_mqtt_event(_platform.mqtt_connected ? PLATFORM_MQTT_CONNECTED : PLATFORM_MQTT_DISCONNECTED);
+}
+
+int platform_mqtt_subscribe(const char *topic)
+{
+    return _platform.mqtt_connected ? 0 : -1;
+}
+
+int platform_mqtt_publish(const char *topic, const char *data, int length)
+{
+    if (!_platform.mqtt_connected)
+        return -1;
+
+    snprintf(_platform.mqtt_last_topic, sizeof(_platform.mqtt_last_topic), "%s", topic);
+    snprintf(_platform.mqtt_last_message, sizeof(_platform.mqtt_last_message), "%.*s", length, data);
+    return (int)++_platform.mqtt_published;
+}
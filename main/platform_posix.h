@@ -0,0 +1,32 @@
+#ifndef _PLATFORM_POSIX_H
+#define _PLATFORM_POSIX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "platform.h"
+
+/*controllo della piattaforma simulata su host (platform_posix.c): orologio virtuale avanzato dal chiamante, relè e led
+  simulati, sensori scriptati, rete e broker mqtt simulati. lo stato è per thread, più simulazioni indipendenti possono
+  girare in parallelo su thread diversi*/
+
+#define PLATFORM_POSIX_MQTT_TOPIC_SIZE 64
+#define PLATFORM_POSIX_MQTT_MESSAGE_SIZE 512
+
+void platform_posix_reset(time_t epoch);
+void platform_posix_advance_us(int64_t us);
+void platform_posix_set_sensors_count(int count);
+void platform_posix_set_sensor(int index, int16_t temp, int16_t humi, bool ok);
+void platform_posix_set_network(bool up);
+void platform_posix_seed_random(uint32_t seed);
+bool platform_posix_relay(void);
+uint32_t platform_posix_relay_switches(void);
+bool platform_posix_led(void);
+bool platform_posix_time_sync_running(void);
+void platform_posix_mqtt_receive(const char *data, int length);
+uint32_t platform_posix_mqtt_published(void);
+const char *platform_posix_mqtt_last_topic(void);
+const char *platform_posix_mqtt_last_message(void);
+
+#endif
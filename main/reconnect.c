@@ -0,0 +1,70 @@
+#include "reconnect.h"
+
+/*collegamento non ancora connesso: la prima connessione viene misurata dall'avvio*/
+
+void reconnect_link_init(reconnect_link_t *link, uint32_t min_delay_ms, uint32_t max_delay_ms)
+{
+    link->min_delay_ms = min_delay_ms;
+    link->max_delay_ms = max_delay_ms;
+    link->attempts = 0;
+    link->connected = false;
+    link->down_since_us = 0;
+    link->stats.disconnections = 0;
+    link->stats.attempts = 0;
+    link->stats.last_outage_ms = 0;
+    link->stats.max_outage_ms = 0;
+}
+
+/*connessione persa, avvia la misura della disconnessione. nessun effetto se il collegamento è già disconnesso*/
+
+void reconnect_link_lost(reconnect_link_t *link, int64_t now_us)
+{
+    if (!link->connected)
+        return;
+
+    link->connected = false;
+    link->down_since_us = now_us;
+    link->attempts = 0;
+    ++link->stats.disconnections;
+}
+
+/*attesa prima del prossimo tentativo: nulla per il primo, per i successivi min_delay_ms raddoppiato ad ogni
+  tentativo fino a max_delay_ms. il jitter sceglie un valore tra metà e l'intera attesa, così più nodi
+  disconnessi insieme non ritentano in sincrono. random è un valore casuale a 32 bit*/
+
+uint32_t reconnect_link_next_delay(reconnect_link_t *link, uint32_t random)
+{
+    uint32_t delay = link->min_delay_ms;
+
+    if (link->attempts++ == 0)
+    {
+        ++link->stats.attempts;
+        return 0;
+    }
+
+    for (uint32_t i = 1; i < link->attempts - 1 && delay < link->max_delay_ms; ++i)
+        delay *= 2;
+    if (delay > link->max_delay_ms)
+        delay = link->max_delay_ms;
+
+    ++link->stats.attempts;
+    return delay / 2 + random % (delay - delay / 2 + 1);
+}
+
+/*connessione stabilita, ritorna la durata della disconnessione in millisecondi (0 se era già connesso)*/
+
+uint32_t reconnect_link_established(reconnect_link_t *link, int64_t now_us)
+{
+    uint32_t outage_ms;
+
+    if (link->connected)
+        return 0;
+
+    outage_ms = (uint32_t)((now_us - link->down_since_us) / 1000);
+    link->connected = true;
+    link->attempts = 0;
+    link->stats.last_outage_ms = outage_ms;
+    if (outage_ms > link->stats.max_outage_ms)
+        link->stats.max_outage_ms = outage_ms;
+    return outage_ms;
+}
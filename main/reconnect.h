@@ -0,0 +1,34 @@
+#ifndef _RECONNECT_H
+#define _RECONNECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*strategia di riconnessione di un collegamento (wi-fi o broker mqtt): primo tentativo immediato, poi attesa
+  esponenziale con jitter fino al massimo. misura la durata di ogni disconnessione. tempi in millisecondi,
+  istanti in microsecondi dall'avvio*/
+
+typedef struct
+{
+    uint32_t disconnections;        //connessioni perse
+    uint32_t attempts;              //tentativi di riconnessione eseguiti
+    uint32_t last_outage_ms;        //durata dell'ultima disconnessione, dalla perdita alla riconnessione
+    uint32_t max_outage_ms;         //durata della disconnessione più lunga
+} reconnect_stats_t;
+
+typedef struct
+{
+    uint32_t min_delay_ms;          //attesa prima del secondo tentativo, raddoppia ad ogni tentativo successivo
+    uint32_t max_delay_ms;
+    uint32_t attempts;              //tentativi dall'ultima connessione riuscita
+    bool connected;
+    int64_t down_since_us;          //istante della perdita della connessione, 0 all'avvio
+    reconnect_stats_t stats;
+} reconnect_link_t;
+
+void reconnect_link_init(reconnect_link_t *link, uint32_t min_delay_ms, uint32_t max_delay_ms);
+void reconnect_link_lost(reconnect_link_t *link, int64_t now_us);
+uint32_t reconnect_link_next_delay(reconnect_link_t *link, uint32_t random);
+uint32_t reconnect_link_established(reconnect_link_t *link, int64_t now_us);
+
+#endif
@@ -0,0 +1,78 @@
+#include "sensorfilter.h"
+
+/*mediana dei primi count valori, ordinati su una copia con insertion sort data la dimensione ridotta della finestra*/
+
+static int16_t _sensor_filter_median(const int16_t *values, int count)
+{
+    int16_t sorted[SENSOR_FILTER_WINDOW];
+
+    for (int i = 0; i < count; ++i)
+    {
+        int j = i;
+
+        for (; j > 0 && sorted[j - 1] > values[i]; --j)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = values[i];
+    }
+
+    return sorted[count / 2];
+}
+
+void sensor_filter_init(sensor_filter_t *filter)
+{
+    filter->head = 0;
+    filter->count = 0;
+    filter->consecutive_rejects = 0;
+    filter->last_accepted_time = 0;
+}
+
+/*inserisce una nuova misura nel filtro se plausibile. la variazione rispetto alla mediana corrente non può superare
+  SENSOR_FILTER_MAX_SLOPE per ogni minuto trascorso dall'ultima misura accettata; dopo SENSOR_FILTER_MAX_REJECTS scarti
+  consecutivi la variazione è considerata reale, il filtro viene svuotato e riparte dal nuovo livello*/
+
+sensor_filter_result_t sensor_filter_push(sensor_filter_t *filter, int16_t temp, int16_t humi, uint32_t now)
+{
+    int16_t median_temp;
+    int16_t median_humi;
+    int32_t minutes;
+    int32_t step;
+
+    if (temp < SENSOR_FILTER_MIN_TEMP || temp > SENSOR_FILTER_MAX_TEMP || humi < SENSOR_FILTER_MIN_HUMI || humi > SENSOR_FILTER_MAX_HUMI)
+        return SENSOR_FILTER_REJECTED_RANGE;
+
+    if (sensor_filter_output(filter, &median_temp, &median_humi))
+    {
+        minutes = (int32_t)((now - filter->last_accepted_time + 59) / 60);
+        if (minutes < 1)
+            minutes = 1;
+        step = temp > median_temp ? temp - median_temp : median_temp - temp;
+
+        if (step > SENSOR_FILTER_MAX_SLOPE * minutes)
+        {
+            if (++filter->consecutive_rejects < SENSOR_FILTER_MAX_REJECTS)
+                return SENSOR_FILTER_REJECTED_SLOPE;
+            sensor_filter_init(filter);
+        }
+    }
+
+    filter->temp[filter->head] = temp;
+    filter->humi[filter->head] = humi;
+    filter->head = (filter->head + 1) % SENSOR_FILTER_WINDOW;
+    if (filter->count < SENSOR_FILTER_WINDOW)
+        ++filter->count;
+    filter->consecutive_rejects = 0;
+    filter->last_accepted_time = now;
+    return SENSOR_FILTER_ACCEPTED;
+}
+
+/*valori filtrati, mediana delle misure accettate. ritorna false se il filtro è ancora vuoto*/
+
+bool sensor_filter_output(const sensor_filter_t *filter, int16_t *temp, int16_t *humi)
+{
+    if (filter->count == 0)
+        return false;
+
+    *temp = _sensor_filter_median(filter->temp, filter->count);
+    *humi = _sensor_filter_median(filter->humi, filter->count);
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef _SENSORFILTER_H
+#define _SENSORFILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*condizionamento delle misure di un sensore: scarto dei valori non plausibili o con variazione troppo rapida
+  e mediana sulle ultime misure accettate. temperatura e umidità in decimi*/
+
+#define SENSOR_FILTER_WINDOW 5
+
+#define SENSOR_FILTER_MIN_TEMP -400     //estremi del dht22, -40°C / 80°C
+#define SENSOR_FILTER_MAX_TEMP 800
+#define SENSOR_FILTER_MIN_HUMI 0
+#define SENSOR_FILTER_MAX_HUMI 1000
+#define SENSOR_FILTER_MAX_SLOPE 20      //massima variazione di temperatura plausibile, in decimi di grado al minuto
+#define SENSOR_FILTER_MAX_REJECTS 3     //scarti consecutivi per pendenza oltre i quali il nuovo livello viene accettato
+
+typedef enum
+{
+    SENSOR_FILTER_ACCEPTED,
+    SENSOR_FILTER_REJECTED_RANGE,
+    SENSOR_FILTER_REJECTED_SLOPE
+} sensor_filter_result_t;
+
+typedef struct
+{
+    int16_t temp[SENSOR_FILTER_WINDOW];     //buffer circolare delle ultime misure accettate
+    int16_t humi[SENSOR_FILTER_WINDOW];
+    uint8_t head;
+    uint8_t count;
+    uint8_t consecutive_rejects;
+    uint32_t last_accepted_time;            //istante dell'ultima misura accettata, in secondi da un riferimento monotono
+} sensor_filter_t;
+
+void sensor_filter_init(sensor_filter_t *filter);
+sensor_filter_result_t sensor_filter_push(sensor_filter_t *filter, int16_t temp, int16_t humi, uint32_t now);
+bool sensor_filter_output(const sensor_filter_t *filter, int16_t *temp, int16_t *humi);
+
+#endif
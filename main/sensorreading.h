@@ -0,0 +1,20 @@
+#ifndef _SENSORREADING_H
+#define _SENSORREADING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*misura di un sensore di temperatura e umidità, indipendente dal driver e dall'hardware:
+  condivisa tra il driver dht, l'interfaccia della piattaforma e le piattaforme simulate su host*/
+
+#define DHT_MAX_SENSORS 4
+
+/*esito della misurazione di un sensore, temperatura e umidità in decimi*/
+
+typedef struct {
+    int16_t temp;
+    int16_t humi;
+    bool ok;
+} dht_reading_t;
+
+#endif
@@ -0,0 +1,262 @@
+#include <string.h>
+
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "settings.h"
+
+/*layout del blob, little endian:
+  [0] versione, [1] switch (bit 0 main_switch, bit 1 prog_switch, bit 2 regolazione tpi), [2..7] target_temp, base_temp, delta_temp in decimi (int16),
+  poi per ogni giorno il numero di valori (uint8) seguito dai valori inizio / fine in minuti (uint16)*/
+
+#define _SETTINGS_HEADER_SIZE 8
+#define _SETTINGS_BLOB_MAX_SIZE (_SETTINGS_HEADER_SIZE + DAYS_PER_WEEK * (1 + 2 * SETTINGS_RUNS_PER_DAY))
+#define _SETTINGS_FLAG_MAIN_SWITCH 0x01
+#define _SETTINGS_FLAG_PROG_SWITCH 0x02
+#define _SETTINGS_OPTIMUM_START_SIZE 23     //versione, 5 somme int32, campioni uint16
+#define _SETTINGS_FLAG_CONTROL_TPI 0x04     //assente nei blob salvati prima dell'introduzione della regolazione tpi, cioè isteresi
+
+static const char *_settings_namespace = "thermostat";
+static const char *_settings_key = "settings";
+static const char *_settings_optimum_start_key = "preheat";
+static const char *_settings_tag = "SETTINGS: ";
+
+static uint8_t _settings_blob[_SETTINGS_BLOB_MAX_SIZE];
+static size_t _settings_length = 0;     //lunghezza del blob serializzato da settings_encode, 0 se non valido
+static uint8_t _settings_saved_blob[_SETTINGS_BLOB_MAX_SIZE];      //ultimo blob scritto o letto, evita le scritture senza modifiche
+static size_t _settings_saved_length = 0;
+static uint8_t _settings_optimum_start_blob[_SETTINGS_OPTIMUM_START_SIZE];
+static bool _settings_optimum_start_encoded = false;      //modello serializzato da scrivere, se diverso dall'ultimo salvato
+static uint8_t _settings_optimum_start_saved_blob[_SETTINGS_OPTIMUM_START_SIZE];
+static bool _settings_optimum_start_saved = false;
+
+static void _settings_put_u16(uint8_t *dest, uint16_t value)
+{
+    dest[0] = value & 0xFF;
+    dest[1] = value >> 8;
+}
+
+static uint16_t _settings_get_u16(const uint8_t *src)
+{
+    return src[0] | (src[1] << 8);
+}
+
+static void _settings_put_u32(uint8_t *dest, uint32_t value)
+{
+    _settings_put_u16(dest, value & 0xFFFF);
+    _settings_put_u16(dest + 2, value >> 16);
+}
+
+static uint32_t _settings_get_u32(const uint8_t *src)
+{
+    return _settings_get_u16(src) | ((uint32_t)_settings_get_u16(src + 2) << 16);
+}
+
+/*serializzazione nel blob, ritorna la lunghezza o 0 se un giorno ha più intervalli di quelli salvabili.
+  la programmazione rifiuta le modifiche oltre RENDERED_INTERVALS_PER_DAY intervalli, per cui non accade*/
+
+static size_t _settings_encode(const thermo_state_t *state, const week_prog_t *week, uint8_t *blob)
+{
+    uint16_t runs[SETTINGS_RUNS_PER_DAY];
+    size_t length = _SETTINGS_HEADER_SIZE;
+    int count;
+
+    blob[0] = SETTINGS_BLOB_VERSION;
+    blob[1] = (state->main_switch ? _SETTINGS_FLAG_MAIN_SWITCH : 0) | (state->prog_switch ? _SETTINGS_FLAG_PROG_SWITCH : 0) | (state->control_mode == THERMO_CONTROL_TPI ? _SETTINGS_FLAG_CONTROL_TPI : 0);
+    _settings_put_u16(blob + 2, (uint16_t)state->target_temp);
+    _settings_put_u16(blob + 4, (uint16_t)state->base_temp);
+    _settings_put_u16(blob + 6, (uint16_t)state->delta_temp);
+
+    for (int day = 0; day < DAYS_PER_WEEK; day++)
+    {
+        count = week_prog_day_runs(week, day, runs, SETTINGS_RUNS_PER_DAY);
+        if (count < 0)
+        {
+            ESP_LOGE(_settings_tag, "day %d: more than %d intervals, settings not saved", day, RENDERED_INTERVALS_PER_DAY);
+            return 0;
+        }
+
+        blob[length++] = count;
+        for (int i = 0; i < count; i++, length += 2)
+            _settings_put_u16(blob + length, runs[i]);
+    }
+
+    return length;
+}
+
+/*lettura del blob salvato: stato e programmazione vengono modificati solo se il blob è integro, della versione corrente
+  e con temperature entro gli estremi dei comandi, altrimenti restano i valori ricevuti. da chiamare all'avvio prima della creazione dei task*/
+
+bool settings_restore(thermo_state_t *state, week_prog_t *week)
+{
+    nvs_handle handle;
+    size_t length = sizeof(_settings_blob);
+    size_t offset = _SETTINGS_HEADER_SIZE;
+    const uint8_t *day_runs[DAYS_PER_WEEK];
+    uint8_t day_counts[DAYS_PER_WEEK];
+    uint16_t runs[SETTINGS_RUNS_PER_DAY];
+    int16_t target_temp, base_temp, delta_temp;
+
+    if (nvs_open(_settings_namespace, NVS_READONLY, &handle) != ESP_OK)
+        return false;
+
+    if (nvs_get_blob(handle, _settings_key, _settings_blob, &length) != ESP_OK)
+    {
+        nvs_close(handle);
+        return false;
+    }
+    nvs_close(handle);
+
+    if (length < _SETTINGS_HEADER_SIZE || _settings_blob[0] != SETTINGS_BLOB_VERSION)
+    {
+        ESP_LOGW(_settings_tag, "discarding settings with unknown layout");
+        return false;
+    }
+
+    target_temp = (int16_t)_settings_get_u16(_settings_blob + 2);
+    base_temp = (int16_t)_settings_get_u16(_settings_blob + 4);
+    delta_temp = (int16_t)_settings_get_u16(_settings_blob + 6);
+
+    //stessi estremi dei comandi, un blob corrotto non può imporre temperature fuori intervallo
+    if (target_temp < MIN_TARGET_TEMP || target_temp > MAX_TARGET_TEMP || base_temp < MIN_BASE_TEMP || base_temp > MAX_BASE_TEMP || delta_temp < MIN_DELTA_TEMP || delta_temp > MAX_DELTA_TEMP)
+    {
+        ESP_LOGW(_settings_tag, "discarding settings with out of range temperatures");
+        return false;
+    }
+
+    for (int day = 0; day < DAYS_PER_WEEK; day++)     //verifica delle lunghezze prima di applicare
+    {
+        if (offset >= length || _settings_blob[offset] > SETTINGS_RUNS_PER_DAY || offset + 1 + 2 * _settings_blob[offset] > length)
+        {
+            ESP_LOGW(_settings_tag, "discarding truncated settings");
+            return false;
+        }
+        day_counts[day] = _settings_blob[offset];
+        day_runs[day] = _settings_blob + offset + 1;
+        offset += 1 + 2 * day_counts[day];
+    }
+
+    for (int day = 0; day < DAYS_PER_WEEK; day++)
+    {
+        for (int i = 0; i < day_counts[day]; i++)
+            runs[i] = _settings_get_u16(day_runs[day] + 2 * i);
+        if (!set_week_prog_day_runs(week, day, runs, day_counts[day]))
+            ESP_LOGW(_settings_tag, "day %d: invalid intervals discarded", day);
+    }
+
+    state->main_switch = _settings_blob[1] & _SETTINGS_FLAG_MAIN_SWITCH;
+    state->prog_switch = _settings_blob[1] & _SETTINGS_FLAG_PROG_SWITCH;
+    state->control_mode = _settings_blob[1] & _SETTINGS_FLAG_CONTROL_TPI ? THERMO_CONTROL_TPI : THERMO_CONTROL_HYSTERESIS;
+    state->target_temp = target_temp;
+    state->base_temp = base_temp;
+    state->delta_temp = delta_temp;
+
+    memcpy(_settings_saved_blob, _settings_blob, length);
+    _settings_saved_length = length;
+    return true;
+}
+
+/*serializzazione di stato e programmazione nel blob in ram, senza accesso alla flash: il chiamante la esegue con la
+  programmazione bloccata e scrive in nvs con settings_write dopo averla rilasciata. ritorna false se non salvabili*/
+
+bool settings_encode(const thermo_state_t *state, const week_prog_t *week)
+{
+    _settings_length = _settings_encode(state, week, _settings_blob);
+    return _settings_length != 0;
+}
+
+/*scrittura in nvs degli ultimi blob serializzati, impostazioni e modello dell'avvio anticipato, con un solo commit.
+  ogni blob viene omesso se non valido o identico all'ultimo salvato. ritorna false solo in caso di errore*/
+
+bool settings_write(void)
+{
+    nvs_handle handle;
+    size_t length = _settings_length;
+    bool settings_changed = length != 0 && (length != _settings_saved_length || memcmp(_settings_blob, _settings_saved_blob, length) != 0);
+    bool optimum_start_changed = _settings_optimum_start_encoded && (!_settings_optimum_start_saved || memcmp(_settings_optimum_start_blob, _settings_optimum_start_saved_blob, _SETTINGS_OPTIMUM_START_SIZE) != 0);
+    esp_err_t err = ESP_OK;
+
+    if (!settings_changed && !optimum_start_changed)
+        return true;
+
+    if (nvs_open(_settings_namespace, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        ESP_LOGE(_settings_tag, "nvs open failed");
+        return false;
+    }
+
+    if (settings_changed)
+        err = nvs_set_blob(handle, _settings_key, _settings_blob, length);
+    if (err == ESP_OK && optimum_start_changed)
+        err = nvs_set_blob(handle, _settings_optimum_start_key, _settings_optimum_start_blob, _SETTINGS_OPTIMUM_START_SIZE);
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(_settings_tag, "nvs write failed: %d", err);
+        return false;
+    }
+
+    if (settings_changed)
+    {
+        memcpy(_settings_saved_blob, _settings_blob, length);
+        _settings_saved_length = length;
+        ESP_LOGI(_settings_tag, "settings saved, %u bytes", (unsigned)length);
+    }
+    if (optimum_start_changed)
+    {
+        memcpy(_settings_optimum_start_saved_blob, _settings_optimum_start_blob, _SETTINGS_OPTIMUM_START_SIZE);
+        _settings_optimum_start_saved = true;
+        ESP_LOGI(_settings_tag, "optimum start model saved");
+    }
+    return true;
+}
+
+/*lettura del modello dell'avvio anticipato, modificato solo se il blob è integro e della versione corrente*/
+
+bool settings_restore_optimum_start(optimum_start_model_t *model)
+{
+    nvs_handle handle;
+    uint8_t blob[_SETTINGS_OPTIMUM_START_SIZE];
+    size_t length = sizeof(blob);
+    esp_err_t err;
+
+    if (nvs_open(_settings_namespace, NVS_READONLY, &handle) != ESP_OK)
+        return false;
+
+    err = nvs_get_blob(handle, _settings_optimum_start_key, blob, &length);
+    nvs_close(handle);
+
+    if (err != ESP_OK || length != _SETTINGS_OPTIMUM_START_SIZE || blob[0] != SETTINGS_OPTIMUM_START_VERSION)
+        return false;
+
+    model->weight = (int32_t)_settings_get_u32(blob + 1);
+    model->sum_temp = (int32_t)_settings_get_u32(blob + 5);
+    model->sum_rate = (int32_t)_settings_get_u32(blob + 9);
+    model->sum_temp_temp = (int32_t)_settings_get_u32(blob + 13);
+    model->sum_temp_rate = (int32_t)_settings_get_u32(blob + 17);
+    model->samples = _settings_get_u16(blob + 21);
+
+    memcpy(_settings_optimum_start_saved_blob, blob, _SETTINGS_OPTIMUM_START_SIZE);
+    _settings_optimum_start_saved = true;
+    return true;
+}
+
+/*serializzazione in ram del modello dell'avvio anticipato, scritto dalla successiva settings_write. il termostato
+  ne passa una copia al task dei comandi, che salva il modello insieme alle impostazioni, poche volte al giorno*/
+
+void settings_encode_optimum_start(const optimum_start_model_t *model)
+{
+    uint8_t *blob = _settings_optimum_start_blob;
+
+    blob[0] = SETTINGS_OPTIMUM_START_VERSION;
+    _settings_put_u32(blob + 1, (uint32_t)model->weight);
+    _settings_put_u32(blob + 5, (uint32_t)model->sum_temp);
+    _settings_put_u32(blob + 9, (uint32_t)model->sum_rate);
+    _settings_put_u32(blob + 13, (uint32_t)model->sum_temp_temp);
+    _settings_put_u32(blob + 17, (uint32_t)model->sum_temp_rate);
+    _settings_put_u16(blob + 21, model->samples);
+    _settings_optimum_start_encoded = true;
+}
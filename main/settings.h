@@ -0,0 +1,27 @@
+#ifndef _SETTINGS_H
+#define _SETTINGS_H
+
+#include <stdbool.h>
+
+#include "thermostate.h"
+#include "timeinterval.h"
+#include "optimumstart.h"
+
+/*persistenza in nvs delle impostazioni dell'utente e della programmazione settimanale in un blob binario versionato:
+  versione, switch, temperature target / base / delta e per ogni giorno le coppie inizio / fine degli intervalli in minuti.
+  il salvataggio è diviso in serializzazione in ram (settings_encode) e scrittura in flash (settings_write), per non
+  tenere bloccata la programmazione durante la scrittura; entrambe vanno chiamate dallo stesso task.
+  il modello dell'avvio anticipato, aggiornato dal termostato e non dai comandi, ha una chiave propria nello stesso namespace:
+  serializzato con settings_encode_optimum_start, viene scritto da settings_write insieme alle impostazioni*/
+
+#define SETTINGS_BLOB_VERSION 1
+#define SETTINGS_OPTIMUM_START_VERSION 1
+#define SETTINGS_RUNS_PER_DAY (2 * RENDERED_INTERVALS_PER_DAY)     //valori inizio / fine salvati per giorno
+
+bool settings_restore(thermo_state_t *state, week_prog_t *week);
+bool settings_encode(const thermo_state_t *state, const week_prog_t *week);
+bool settings_write(void);
+bool settings_restore_optimum_start(optimum_start_model_t *model);
+void settings_encode_optimum_start(const optimum_start_model_t *model);
+
+#endif
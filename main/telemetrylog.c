@@ -0,0 +1,129 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "telemetrylog.h"
+
+static telemetry_event_t _telemetry_log[CONFIG_THERMO_OFFLINE_LOG_EVENTS];
+static int _telemetry_log_head;         //indice dell'evento più vecchio
+static int _telemetry_log_count;
+static uint32_t _telemetry_log_first_sequence;  //numero progressivo dell'evento più vecchio
+static bool _telemetry_log_recording;   //nodo offline o ripubblicazione in corso, gli eventi vengono registrati
+static telemetry_log_stats_t _telemetry_log_stats;
+
+static void _telemetry_log_push(const telemetry_event_t *event)
+{
+    taskENTER_CRITICAL();
+
+    if (_telemetry_log_recording)
+    {
+        if (_telemetry_log_count == CONFIG_THERMO_OFFLINE_LOG_EVENTS)    //buffer pieno, sovrascrittura dell'evento più vecchio
+        {
+            _telemetry_log_head = (_telemetry_log_head + 1) % CONFIG_THERMO_OFFLINE_LOG_EVENTS;
+            --_telemetry_log_count;
+            ++_telemetry_log_first_sequence;
+            ++_telemetry_log_stats.overwritten;
+        }
+
+        _telemetry_log[(_telemetry_log_head + _telemetry_log_count) % CONFIG_THERMO_OFFLINE_LOG_EVENTS] = *event;
+        ++_telemetry_log_count;
+        ++_telemetry_log_stats.recorded;
+    }
+
+    taskEXIT_CRITICAL();
+}
+
+/*registro vuoto e in registrazione: gli eventi precedenti alla prima connessione vengono ripubblicati*/
+
+void telemetry_log_init(void)
+{
+    _telemetry_log_head = 0;
+    _telemetry_log_count = 0;
+    _telemetry_log_first_sequence = 0;
+    _telemetry_log_recording = true;
+}
+
+/*avvio della registrazione alla perdita della connessione*/
+
+void telemetry_log_start_recording(void)
+{
+    taskENTER_CRITICAL();
+    _telemetry_log_recording = true;
+    taskEXIT_CRITICAL();
+}
+
+void telemetry_log_add_measure(time_t now, int16_t temp, int16_t humi)
+{
+    telemetry_event_t event = {.time = (uint32_t)now, .temp = temp, .humi = humi, .type = TELEMETRY_EVENT_MEASURE};
+
+    _telemetry_log_push(&event);
+}
+
+void telemetry_log_add_relay(time_t now, bool thermo_on)
+{
+    telemetry_event_t event = {.time = (uint32_t)now, .type = TELEMETRY_EVENT_RELAY, .thermo_on = thermo_on};
+
+    _telemetry_log_push(&event);
+}
+
+/*copia fino a max eventi a partire dal più vecchio senza rimuoverli, ritorna il numero di eventi copiati e in first
+  il numero progressivo del primo. gli eventi vanno rimossi con telemetry_log_consume solo dopo la pubblicazione riuscita*/
+
+int telemetry_log_peek(telemetry_event_t *events, int max, uint32_t *first)
+{
+    int count;
+
+    taskENTER_CRITICAL();
+
+    *first = _telemetry_log_first_sequence;
+    count = _telemetry_log_count < max ? _telemetry_log_count : max;
+    for (int i = 0; i < count; ++i)
+        events[i] = _telemetry_log[(_telemetry_log_head + i) % CONFIG_THERMO_OFFLINE_LOG_EVENTS];
+
+    taskEXIT_CRITICAL();
+    return count;
+}
+
+/*rimuove i count eventi pubblicati a partire dal numero progressivo first. gli eventi sovrascritti
+  nel frattempo sono già stati rimossi, per cui vengono tolti solo quelli ancora presenti*/
+
+void telemetry_log_consume(uint32_t first, int count)
+{
+    uint32_t overwritten;
+
+    taskENTER_CRITICAL();
+
+    overwritten = _telemetry_log_first_sequence - first;
+    count = (uint32_t)count > overwritten ? count - (int)overwritten : 0;
+    if (count > _telemetry_log_count)
+        count = _telemetry_log_count;
+    _telemetry_log_head = (_telemetry_log_head + count) % CONFIG_THERMO_OFFLINE_LOG_EVENTS;
+    _telemetry_log_count -= count;
+    _telemetry_log_first_sequence += count;
+    _telemetry_log_stats.replayed += count;
+
+    taskEXIT_CRITICAL();
+}
+
+/*conclude la ripubblicazione se il registro è vuoto, in modo atomico rispetto alla registrazione di nuovi eventi:
+  ritorna false se nel frattempo sono arrivati altri eventi da ripubblicare*/
+
+bool telemetry_log_finish_replay(void)
+{
+    bool finished;
+
+    taskENTER_CRITICAL();
+
+    finished = _telemetry_log_count == 0;
+    if (finished)
+        _telemetry_log_recording = false;
+
+    taskEXIT_CRITICAL();
+    return finished;
+}
+
+void telemetry_log_get_stats(telemetry_log_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _telemetry_log_stats;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,43 @@
+#ifndef _TELEMETRYLOG_H
+#define _TELEMETRYLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*registro degli eventi di telemetria mentre il nodo è offline: misure e cambi di stato del relè vengono
+  accodati con il loro istante in un buffer circolare statico e ripubblicati alla riconnessione.
+  a buffer pieno l'evento più vecchio viene sovrascritto*/
+
+typedef enum
+{
+    TELEMETRY_EVENT_MEASURE,
+    TELEMETRY_EVENT_RELAY
+} telemetry_event_type_t;
+
+typedef struct
+{
+    uint32_t time;              //istante dell'evento, secondi dall'epoch (dall'avvio se l'orologio non è ancora sincronizzato)
+    int16_t temp;               //misura, in decimi
+    int16_t humi;
+    uint8_t type;               //telemetry_event_type_t
+    bool thermo_on;             //nuovo stato del relè
+} telemetry_event_t;
+
+typedef struct
+{
+    uint32_t recorded;          //eventi registrati offline
+    uint32_t overwritten;       //eventi più vecchi persi per buffer pieno
+    uint32_t replayed;          //eventi ripubblicati
+} telemetry_log_stats_t;
+
+void telemetry_log_init(void);
+void telemetry_log_start_recording(void);
+void telemetry_log_add_measure(time_t now, int16_t temp, int16_t humi);
+void telemetry_log_add_relay(time_t now, bool thermo_on);
+int telemetry_log_peek(telemetry_event_t *events, int max, uint32_t *first);
+void telemetry_log_consume(uint32_t first, int count);
+bool telemetry_log_finish_replay(void);
+void telemetry_log_get_stats(telemetry_log_stats_t *stats);
+
+#endif
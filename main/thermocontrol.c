@@ -0,0 +1,144 @@
+#include "thermocontrol.h"
+
+/*
+verifica se l'ora corrente è compresa in un intervallo di programmazione o se la programmazione oraria è disattivata
+e se la temperatura corrente è inferiore alla temperatura desiderata, se necessario accende il riscaldamento.
+prog_active è true anche con programmazione disattivata
+*/
+
+bool thermo_control_relay(const thermo_state_t *state, bool prog_active)
+{
+    if (state->main_switch && prog_active && state->current_temp < state->target_temp)
+        return true;
+
+    //fino al raggiungimento della temperatura desiderata più il delta il riscaldamento resta acceso
+
+    if (state->main_switch && prog_active && state->thermo_on && state->current_temp <= state->target_temp + state->delta_temp)
+        return true;
+
+    //sotto la temperatura di base il riscaldamento parte comunque
+
+    return state->current_temp < state->base_temp;
+}
+
+#define _THERMO_TPI_FULL_DUTY 1000
+#define _THERMO_TPI_MAX_ERROR 500       //errore massimo considerato, 50°C
+#define _THERMO_TPI_SECONDS_PER_HOUR 3600
+
+void thermo_tpi_init(thermo_tpi_t *tpi, const thermo_tpi_params_t *params)
+{
+    tpi->params = *params;
+    tpi->integral = 0;
+    tpi->setpoint = 0;
+    tpi->duty = 0;
+    tpi->cycle_start = 0;
+    tpi->on_s = 0;
+    tpi->last_switch = 0;
+    tpi->cycle_running = false;
+    tpi->switched = false;
+    tpi->relay_on = false;
+}
+
+/*nuovo ciclo: aggiornamento del regolatore pi e calcolo della durata dell'accensione. l'errore viene integrato per il
+  tempo trascorso dall'inizio del ciclo precedente solo se l'uscita non è saturata nella stessa direzione (anti-windup),
+  le accensioni e gli spegnimenti più brevi dei minimi vengono eliminati. al cambio di setpoint il termine integrale,
+  accumulato per mantenere il setpoint precedente, riparte da zero*/
+
+static void _thermo_tpi_start_cycle(thermo_tpi_t *tpi, int16_t setpoint, int16_t current, uint32_t now)
+{
+    const thermo_tpi_params_t *params = &tpi->params;
+    int32_t error = setpoint - current;
+    int32_t output;
+    int64_t integral;
+    uint32_t elapsed;
+
+    if (tpi->cycle_running && setpoint != tpi->setpoint)
+    {
+        tpi->integral = 0;
+        tpi->cycle_running = false;     //il ciclo interrotto non viene integrato con l'errore del nuovo setpoint
+    }
+
+    if (error > _THERMO_TPI_MAX_ERROR)
+        error = _THERMO_TPI_MAX_ERROR;
+    else if (error < -_THERMO_TPI_MAX_ERROR)
+        error = -_THERMO_TPI_MAX_ERROR;
+
+    output = params->kp * error + tpi->integral / _THERMO_TPI_SECONDS_PER_HOUR;
+
+    if (tpi->cycle_running && (output < _THERMO_TPI_FULL_DUTY || error < 0) && (output > 0 || error > 0))
+    {
+        elapsed = now - tpi->cycle_start;
+        if (elapsed > params->cycle_s)
+            elapsed = params->cycle_s;
+
+        integral = tpi->integral + (int64_t)params->ki * error * elapsed;
+        if (integral < 0)
+            integral = 0;
+        else if (integral > (int64_t)_THERMO_TPI_FULL_DUTY * _THERMO_TPI_SECONDS_PER_HOUR)
+            integral = (int64_t)_THERMO_TPI_FULL_DUTY * _THERMO_TPI_SECONDS_PER_HOUR;
+        tpi->integral = (int32_t)integral;
+
+        output = params->kp * error + tpi->integral / _THERMO_TPI_SECONDS_PER_HOUR;
+    }
+
+    if (output < 0)
+        output = 0;
+    else if (output > _THERMO_TPI_FULL_DUTY)
+        output = _THERMO_TPI_FULL_DUTY;
+
+    tpi->duty = output;
+    tpi->on_s = (uint32_t)((uint64_t)params->cycle_s * output / _THERMO_TPI_FULL_DUTY);
+    if (tpi->on_s < params->min_on_s)
+        tpi->on_s = 0;
+    else if (params->cycle_s - tpi->on_s < params->min_off_s)
+        tpi->on_s = params->cycle_s;
+
+    tpi->setpoint = setpoint;
+    tpi->cycle_start = now;
+    tpi->cycle_running = true;
+}
+
+/*stato del relè all'istante now. un nuovo ciclo parte allo scadere del precedente o al cambio di setpoint; un cambio di
+  stato viene rimandato finché il relè non è rimasto nello stato attuale per il tempo minimo. con force_on (soglia della
+  temperatura di base) il relè viene acceso subito, senza attendere lo spegnimento minimo, e lo stato interno resta
+  quello reale del relè. in next_event l'istante della prossima variazione prevista, a cui va richiamata la funzione*/
+
+bool thermo_tpi_update(thermo_tpi_t *tpi, int16_t setpoint, int16_t current, bool force_on, uint32_t now, uint32_t *next_event)
+{
+    uint32_t min_hold;
+    bool cycle_on;
+    bool desired;
+
+    if (!tpi->cycle_running || now - tpi->cycle_start >= tpi->params.cycle_s || setpoint != tpi->setpoint)
+        _thermo_tpi_start_cycle(tpi, setpoint, current, now);
+
+    cycle_on = now - tpi->cycle_start < tpi->on_s;
+    desired = force_on || cycle_on;
+    min_hold = tpi->relay_on ? tpi->params.min_on_s : tpi->params.min_off_s;
+
+    if (desired != tpi->relay_on && !force_on && tpi->switched && now - tpi->last_switch < min_hold)
+    {
+        *next_event = tpi->last_switch + min_hold;
+        return tpi->relay_on;
+    }
+
+    if (desired != tpi->relay_on)
+    {
+        tpi->relay_on = desired;
+        tpi->last_switch = now;
+        tpi->switched = true;
+    }
+
+    *next_event = tpi->cycle_start + (cycle_on ? tpi->on_s : tpi->params.cycle_s);
+    return desired;
+}
+
+/*regolazione tpi verso la temperatura target negli intervalli attivi e verso la temperatura di base negli altri casi,
+  sotto la temperatura di base il riscaldamento resta comunque acceso*/
+
+bool thermo_control_tpi_relay(thermo_tpi_t *tpi, const thermo_state_t *state, bool prog_active, uint32_t now, uint32_t *next_event)
+{
+    int16_t setpoint = state->main_switch && prog_active ? state->target_temp : state->base_temp;
+
+    return thermo_tpi_update(tpi, setpoint, state->current_temp, state->current_temp < state->base_temp, now, next_event);
+}
@@ -0,0 +1,44 @@
+#ifndef _THERMOCONTROL_H
+#define _THERMOCONTROL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "thermostate.h"
+
+/*logica di decisione del termostato, senza dipendenze da freertos e dall'hardware: dato lo stato corrente
+  e se la programmazione oraria è attiva decide lo stato del relè. temperature in decimi di grado, istanti in secondi
+  da un riferimento monotono*/
+
+/*parametri della regolazione a tempo proporzionale (tpi): ad ogni ciclo il regolatore pi calcola la frazione del ciclo
+  in cui il relè resta acceso, in millesimi*/
+
+typedef struct
+{
+    uint32_t cycle_s;           //durata del ciclo
+    int32_t kp;                 //millesimi di ciclo acceso per decimo di grado sotto il setpoint
+    int32_t ki;                 //millesimi di ciclo acceso per decimo di grado sotto il setpoint e per ora
+    uint32_t min_on_s;          //accensione minima del relè, accensioni più brevi vengono omesse
+    uint32_t min_off_s;         //spegnimento minimo del relè, spegnimenti più brevi vengono omessi
+} thermo_tpi_params_t;
+
+typedef struct
+{
+    thermo_tpi_params_t params;
+    int32_t integral;           //termine integrale in millesimi moltiplicati per 3600, limitato tra 0 e il ciclo intero
+    int16_t setpoint;           //setpoint del ciclo corrente
+    uint16_t duty;              //frazione accesa del ciclo corrente, in millesimi
+    uint32_t cycle_start;
+    uint32_t on_s;              //durata dell'accensione nel ciclo corrente
+    uint32_t last_switch;       //istante dell'ultimo cambio di stato del relè
+    bool cycle_running;
+    bool switched;              //almeno un cambio di stato dall'inizializzazione, last_switch valido
+    bool relay_on;
+} thermo_tpi_t;
+
+bool thermo_control_relay(const thermo_state_t *state, bool prog_active);
+void thermo_tpi_init(thermo_tpi_t *tpi, const thermo_tpi_params_t *params);
+bool thermo_tpi_update(thermo_tpi_t *tpi, int16_t setpoint, int16_t current, bool force_on, uint32_t now, uint32_t *next_event);
+bool thermo_control_tpi_relay(thermo_tpi_t *tpi, const thermo_state_t *state, bool prog_active, uint32_t now, uint32_t *next_event);
+
+#endif
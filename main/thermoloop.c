@@ -0,0 +1,70 @@
+#include "thermoloop.h"
+
+void thermo_loop_init(thermo_loop_t *loop, const thermo_tpi_params_t *tpi_params, optimum_start_model_t *model, uint32_t max_lead_s, uint32_t min_run_s)
+{
+    thermo_tpi_init(&loop->tpi, tpi_params);
+    loop->control_mode = THERMO_CONTROL_HYSTERESIS;
+    loop->model = model;
+    optimum_start_run_init(&loop->heating_run);
+    loop->preheat_transition = (time_t)-1;
+    loop->preheat_done = false;
+    loop->max_lead_s = max_lead_s;
+    loop->min_run_s = min_run_s;
+}
+
+/*una valutazione del termostato. in_interval indica se l'istante corrente è in un intervallo programmato e
+  next_transition il prossimo cambio di stato della programmazione (-1 se nessuno), entrambi falsi / -1 in modalità
+  sicura. con l'avvio anticipato l'intervallo successivo è considerato attivo già dall'anticipo previsto dal modello
+  appreso, per raggiungere la temperatura target all'inizio dell'intervallo. una volta partito il preriscaldamento non
+  dipende più dall'anticipo: questo si riduce mentre la stanza si scalda, e ricalcolato ad ogni risveglio spegnerebbe
+  e riaccenderebbe il relè con accensioni brevi*/
+
+void thermo_loop_evaluate(thermo_loop_t *loop, const thermo_state_t *state, bool in_interval, time_t next_transition, time_t now, uint32_t uptime, thermo_loop_result_t *result)
+{
+    uint32_t preheat_lead = 0;
+
+    result->prog_active = state->prog_switch == false || in_interval;
+
+    //intervallo iniziato, impianto spento o programmazione modificata: il preriscaldamento in corso termina
+    if (result->prog_active || !state->main_switch || next_transition != loop->preheat_transition)
+        loop->preheat_transition = (time_t)-1;
+
+    //fuori da un intervallo il prossimo cambio di stato è un inizio, anticipato del tempo di riscaldamento previsto.
+    //il preriscaldamento partito resta attivo fino alla temperatura target, poi la stanza prosegue per inerzia e
+    //riparte solo se l'anticipo previsto torna a superare il tempo mancante
+    if (loop->preheat_transition != (time_t)-1 && !loop->preheat_done)
+    {
+        result->prog_active = true;
+        loop->preheat_done = state->current_temp >= state->target_temp;
+    }
+    else if (loop->model && !result->prog_active && state->main_switch && state->dht_ok && next_transition != (time_t)-1)
+    {
+        preheat_lead = optimum_start_lead_s(loop->model, state->current_temp, state->target_temp, loop->max_lead_s);
+        result->prog_active = next_transition - now <= (time_t)preheat_lead;
+        if (result->prog_active)
+        {
+            loop->preheat_transition = next_transition;
+            loop->preheat_done = false;
+        }
+    }
+
+    if (state->control_mode != loop->control_mode)     //cambio di algoritmo, il regolatore riparte da zero
+    {
+        loop->control_mode = state->control_mode;
+        thermo_tpi_init(&loop->tpi, &loop->tpi.params);
+    }
+
+    result->tpi_pending = loop->control_mode == THERMO_CONTROL_TPI;
+    if (result->tpi_pending)
+        result->relay_on = thermo_control_tpi_relay(&loop->tpi, state, result->prog_active, uptime, &result->tpi_next_event);
+    else
+        result->relay_on = thermo_control_relay(state, result->prog_active);
+
+    //ogni accensione abbastanza lunga aggiorna la velocità di riscaldamento appresa
+    result->model_updated = loop->model && optimum_start_observe(loop->model, &loop->heating_run, uptime, state->current_temp, result->relay_on, state->dht_ok, loop->min_run_s);
+
+    //un inizio viene anticipato all'avvio del preriscaldamento se non ancora raggiunto
+    result->next_wakeup = next_transition;
+    if (next_transition != (time_t)-1 && next_transition - now > (time_t)preheat_lead)
+        result->next_wakeup -= preheat_lead;
+}
@@ -0,0 +1,42 @@
+#ifndef _THERMOLOOP_H
+#define _THERMOLOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "optimumstart.h"
+#include "thermocontrol.h"
+#include "thermostate.h"
+
+/*valutazione del termostato ad ogni risveglio, senza dipendenze da freertos e dall'hardware, condivisa tra thermo_task
+  e il simulatore: programmazione attiva con l'avvio anticipato, scelta dell'algoritmo, decisione del relè, apprendimento
+  della velocità di riscaldamento e prossimo risveglio. la programmazione viene letta dal chiamante, che ne gestisce
+  il blocco. istanti in secondi, now dall'epoch e uptime da un riferimento monotono*/
+
+typedef struct
+{
+    thermo_tpi_t tpi;
+    uint8_t control_mode;               //algoritmo in uso, al cambio il regolatore tpi riparte da zero
+    optimum_start_model_t *model;       //modello dell'avvio anticipato, NULL se disabilitato
+    optimum_start_run_t heating_run;
+    time_t preheat_transition;          //inizio dell'intervallo per cui il preriscaldamento è partito, -1 se nessuno
+    bool preheat_done;                  //temperatura target raggiunta durante il preriscaldamento
+    uint32_t max_lead_s;                //anticipo massimo dell'avvio
+    uint32_t min_run_s;                 //durata minima di un'accensione per l'apprendimento
+} thermo_loop_t;
+
+typedef struct
+{
+    bool relay_on;
+    bool prog_active;                   //intervallo programmato in corso, in preriscaldamento o programmazione disattivata
+    bool tpi_pending;                   //regolazione tpi attiva, tpi_next_event valido
+    uint32_t tpi_next_event;            //prossimo cambio di stato del relè previsto dal regolatore tpi, in uptime
+    time_t next_wakeup;                 //prossimo cambio di stato della programmazione o inizio del preriscaldamento, -1 se nessuno
+    bool model_updated;                 //nuovo campione appreso, il modello va salvato
+} thermo_loop_result_t;
+
+void thermo_loop_init(thermo_loop_t *loop, const thermo_tpi_params_t *tpi_params, optimum_start_model_t *model, uint32_t max_lead_s, uint32_t min_run_s);
+void thermo_loop_evaluate(thermo_loop_t *loop, const thermo_state_t *state, bool in_interval, time_t next_transition, time_t now, uint32_t uptime, thermo_loop_result_t *result);
+
+#endif
@@ -0,0 +1,73 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "thermostate.h"
+
+/*
+  seqlock sullo stato del termostato: i lettori copiano lo stato senza mutex e ripetono la copia se nel frattempo
+  è avvenuta una scrittura, i numeri di sequenza dispari indicano una scrittura in corso.
+  le scritture avvengono in sezione critica su una copia di lavoro e vengono pubblicate solo se lo stato cambia,
+  per cui la versione (sequenza / 2) conta le modifiche effettive dello stato
+*/
+
+#define _THERMO_STATE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+static thermo_state_t _thermo_state;
+static thermo_state_t _thermo_state_pending;
+static volatile uint32_t _thermo_state_sequence;
+
+/*inizializzazione dello stato, da chiamare prima della creazione dei task*/
+
+void thermo_state_init(const thermo_state_t *initial_state)
+{
+    _thermo_state = *initial_state;
+    _thermo_state_sequence = 0;
+}
+
+/*copia consistente dello stato senza acquisire lock, ritorna la versione dello stato copiato*/
+
+uint32_t thermo_state_read(thermo_state_t *snapshot)
+{
+    uint32_t sequence;
+
+    do
+    {
+        sequence = _thermo_state_sequence;
+        _THERMO_STATE_BARRIER();
+        *snapshot = _thermo_state;
+        _THERMO_STATE_BARRIER();
+    } while ((sequence & 1) || sequence != _thermo_state_sequence);
+
+    return sequence >> 1;
+}
+
+/*inizio di una scrittura: ritorna la copia di lavoro dello stato corrente da modificare,
+  deve essere seguita a breve da thermo_state_write_end poiché la sezione critica resta aperta*/
+
+thermo_state_t *thermo_state_write_begin(void)
+{
+    taskENTER_CRITICAL();
+    _thermo_state_pending = _thermo_state;
+    return &_thermo_state_pending;
+}
+
+/*fine di una scrittura: pubblica la copia di lavoro se diversa dallo stato corrente, ritorna true se lo stato è cambiato*/
+
+bool thermo_state_write_end(void)
+{
+    bool changed = memcmp(&_thermo_state_pending, &_thermo_state, sizeof(thermo_state_t)) != 0;
+
+    if (changed)
+    {
+        _thermo_state_sequence++;
+        _THERMO_STATE_BARRIER();
+        _thermo_state = _thermo_state_pending;
+        _THERMO_STATE_BARRIER();
+        _thermo_state_sequence++;
+    }
+
+    taskEXIT_CRITICAL();
+    return changed;
+}
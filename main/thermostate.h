@@ -0,0 +1,47 @@
+#ifndef _THERMOSTATE_H
+#define _THERMOSTATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*stato globale del termostato, condiviso tra i task tramite seqlock.
+  temperature e umidità in virgola fissa, in decimi di grado e di punto percentuale*/
+
+/*estremi per valori di temperatura in decimi di grado centigrado, validi per i comandi e per le impostazioni salvate*/
+
+#define MIN_TARGET_TEMP 150
+#define MAX_TARGET_TEMP 300
+
+#define MIN_BASE_TEMP 50
+#define MAX_BASE_TEMP 150
+
+#define MIN_DELTA_TEMP 0
+#define MAX_DELTA_TEMP 10
+
+typedef enum
+{
+    THERMO_CONTROL_HYSTERESIS,      //acceso / spento con isteresi delta_temp
+    THERMO_CONTROL_TPI              //cicli a tempo proporzionale comandati da un regolatore pi
+} thermo_control_mode_t;
+
+typedef struct
+{
+    int16_t target_temp;    //temperatura target desiderata
+    int16_t base_temp;      //temperatura minima sotto la quale il riscaldamento parte comunque
+    int16_t delta_temp;     //differenza di temperatura dal target per lo spegnimento del riscaldamento
+    int16_t current_temp;   //temperatura corrente rilevata
+    int16_t current_humi;   //umidità corrente rilevata
+    bool main_switch;       //switch generale termostato
+    bool prog_switch;       //switch attivazione / disattivazione programmazione oraria
+    bool thermo_on;         //stato riscaldamento acceso / spento
+    bool node_online;       //stato connessione wi-fi e mqtt
+    bool dht_ok;            //stato sensore dht per rilevazione temperatura e umidità
+    uint8_t control_mode;   //thermo_control_mode_t, algoritmo di regolazione
+} thermo_state_t;
+
+void thermo_state_init(const thermo_state_t *initial_state);
+uint32_t thermo_state_read(thermo_state_t *snapshot);
+thermo_state_t *thermo_state_write_begin(void);
+bool thermo_state_write_end(void);
+
+#endif
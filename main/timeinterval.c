@@ -1,10 +1,17 @@
-#ifndef _GNU_SOURCE     //utilizzato durante il testing su linux non necessario su esp
-#define _GNU_SOURCE
-#endif
-
 #include <limits.h>
 #include "timeinterval.h"
-#include <stdio.h>
+#include "timestring.h"
+#include <string.h>
+
+/*scrive l'intervallo nel formato HH:MM/HH:MM senza terminatore, ritorna il numero di caratteri scritti*/
+
+static int _sprint_interval(char *dest, int start_minute, int end_minute)
+{
+    format_daytime_hhmm(start_minute, dest);
+    dest[DAYTIME_HHMM_LENGTH] = '/';
+    format_daytime_hhmm(end_minute, dest + DAYTIME_HHMM_LENGTH + 1);
+    return 2 * DAYTIME_HHMM_LENGTH + 1;
+}
 
 /*inserisce un intervallo temporale in un array di intervalli, verificando e risolvendo eventuali sovrapposizioni
   ritorna true se l'intervallo viene inserito con successo nell'array, false altrimenti
@@ -12,18 +19,11 @@
 
 bool insert_into_interval_array(daytime_interval_sec_t arr[], const char *start_time, const char *end_time, const int size)
 {
-    struct tm temp = {0};
     daytime_interval_sec_t interval_to_insert = {0};
 
-    strptime(start_time, "%H:%M:%S", &temp);
-    interval_to_insert.start_sec = temp.tm_hour * SECONDS_PER_HOUR + temp.tm_min * SECONDS_PER_MINUTE + temp.tm_sec;
-
-    temp.tm_hour = 0;
-    temp.tm_min = 0;
-    temp.tm_sec = 0;
+    if (parse_daytime(start_time, &interval_to_insert.start_sec, NULL) != TIME_STRING_OK || parse_daytime(end_time, &interval_to_insert.end_sec, NULL) != TIME_STRING_OK)
+        return false;
 
-    strptime(end_time, "%H:%M:%S", &temp);
-    interval_to_insert.end_sec = temp.tm_hour * SECONDS_PER_HOUR + temp.tm_min * SECONDS_PER_MINUTE + temp.tm_sec;
     if(interval_to_insert.end_sec == 0)
         interval_to_insert.end_sec = SECONDS_PER_DAY;
 
@@ -113,21 +113,18 @@ void init_interval_array(daytime_interval_sec_t arr[], int size)
 
 int sprint_intervals(const daytime_interval_sec_t arr[], const int arrsize, char *dest, const int destsize)
 {
-    struct tm tmp = {0};
     int index = 0;
     int offset = 0;
 
     if(destsize < 13)
         return 0;
 
+    //ogni intervallo occupa 13 caratteri compreso il separatore ", "
     while(index < arrsize && destsize - offset >= 13 && !IS_FREE_BOX(arr[index]))
     {
-        tmp.tm_hour = arr[index].start_sec / SECONDS_PER_HOUR;
-        tmp.tm_min = (arr[index].start_sec % SECONDS_PER_HOUR) / SECONDS_PER_MINUTE;
-        offset += strftime(dest + offset, destsize, "%H:%M/", &tmp);
-        tmp.tm_hour = arr[index].end_sec / SECONDS_PER_HOUR;
-        tmp.tm_min = (arr[index].end_sec % SECONDS_PER_HOUR) / SECONDS_PER_MINUTE;
-        offset += strftime(dest + offset, destsize, "%H:%M, ", &tmp);
+        offset += _sprint_interval(dest + offset, arr[index].start_sec / SECONDS_PER_MINUTE, arr[index].end_sec / SECONDS_PER_MINUTE);
+        dest[offset++] = ',';
+        dest[offset++] = ' ';
         ++index;
     }
     if(index > 0)
@@ -166,4 +163,447 @@ bool time_in_interval(const struct tm *test_time, const daytime_interval_sec_t a
         return true;
     else
         return false;
-}
\ No newline at end of file
+}
+
+/*
+  BACKEND BITMAP
+  la giornata è rappresentata da 1440 bit, uno per minuto: la ricerca è un singolo test di bit,
+  inserimento e cancellazione operano su word intere tramite maschere, senza limite al numero di intervalli.
+  la programmazione settimanale limita però ogni giorno a RENDERED_INTERVALS_PER_DAY intervalli, quanti ne entrano nella
+  stringa pubblicata e nel blob salvato in nvs
+*/
+
+/*setta (value true) o azzera (value false) i minuti dell'intervallo [first, last)*/
+
+static void _day_bitmap_fill(day_bitmap_t *day, int first, int last, bool value)
+{
+    while (first < last)
+    {
+        int bit = first & 31;
+        int count = last - first;
+        uint32_t mask;
+
+        if (count > 32 - bit)
+            count = 32 - bit;
+
+        mask = (count == 32) ? 0xFFFFFFFF : (((uint32_t)1 << count) - 1) << bit;
+
+        if (value)
+            day->words[first >> 5] |= mask;
+        else
+            day->words[first >> 5] &= ~mask;
+
+        first += count;
+    }
+}
+
+/*inserisce l'intervallo [start_sec, end_sec) arrotondato al minuto, una fine pari a 00:00 indica la mezzanotte successiva.
+  con day NULL si limita a verificare la validità dell'intervallo
+*/
+
+static bool _day_bitmap_insert_sec(day_bitmap_t *day, int start_sec, int end_sec)
+{
+    if (end_sec == 0)
+        end_sec = SECONDS_PER_DAY;
+
+    if (start_sec < 0 || start_sec >= SECONDS_PER_DAY || end_sec <= 0 || end_sec > SECONDS_PER_DAY || start_sec >= end_sec)
+        return false;
+
+    //il minuto di fine viene arrotondato per eccesso, l'intervallo copre [inizio, fine)
+    if (day)
+        _day_bitmap_fill(day, start_sec / SECONDS_PER_MINUTE, (end_sec + SECONDS_PER_MINUTE - 1) / SECONDS_PER_MINUTE, true);
+    return true;
+}
+
+/*analizza in un solo passaggio una lista di intervalli nel formato "HH:MM/HH:MM, HH:MM/HH:MM" prodotto da sprint_day_bitmap
+  e, se day non è NULL, li inserisce nella bitmap: le sovrapposizioni e l'ordine non richiedono ordinamento né fusione.
+  ritorna true se tutta la lista è valida, una lista vuota è valida
+*/
+
+static bool _parse_interval_list(const char *intervals, day_bitmap_t *day)
+{
+    int start_sec, end_sec;
+
+    while (*intervals == ' ')
+        ++intervals;
+
+    while (*intervals != '\0')
+    {
+        if (parse_daytime(intervals, &start_sec, &intervals) != TIME_STRING_OK || *intervals++ != '/')
+            return false;
+
+        if (parse_daytime(intervals, &end_sec, &intervals) != TIME_STRING_OK || !_day_bitmap_insert_sec(day, start_sec, end_sec))
+            return false;
+
+        while (*intervals == ' ')
+            ++intervals;
+
+        if (*intervals == ',')
+        {
+            ++intervals;
+            while (*intervals == ' ')
+                ++intervals;
+            if (*intervals == '\0')
+                return false;
+        }
+        else if (*intervals != '\0')
+            return false;
+    }
+
+    return true;
+}
+
+/*ritorna il valore del bit relativo al minuto dato*/
+
+static bool _day_bitmap_test(const day_bitmap_t *day, int minute)
+{
+    return (day->words[minute >> 5] >> (minute & 31)) & 1;
+}
+
+/*ritorna il primo minuto a partire da from il cui bit vale value, MINUTES_PER_DAY se non esiste*/
+
+static int _day_bitmap_find(const day_bitmap_t *day, int from, bool value)
+{
+    int index = from >> 5;
+    uint32_t word;
+
+    if (from >= MINUTES_PER_DAY)
+        return MINUTES_PER_DAY;
+
+    word = value ? day->words[index] : ~day->words[index];
+    word &= 0xFFFFFFFF << (from & 31);     //scarta i minuti precedenti a from
+
+    while (word == 0)
+    {
+        if (++index == DAY_BITMAP_WORDS)
+            return MINUTES_PER_DAY;
+        word = value ? day->words[index] : ~day->words[index];
+    }
+
+    return (index << 5) + __builtin_ctz(word);
+}
+
+/*numero di intervalli distinti della giornata*/
+
+static int _day_bitmap_runs(const day_bitmap_t *day)
+{
+    int count = 0;
+    int start = _day_bitmap_find(day, 0, true);
+
+    while (start < MINUTES_PER_DAY)
+    {
+        count++;
+        start = _day_bitmap_find(day, _day_bitmap_find(day, start, false), true);
+    }
+
+    return count;
+}
+
+/*inserisce un intervallo temporale nella programmazione giornaliera, le sovrapposizioni si risolvono da sole
+  ritorna true se l'intervallo è valido e viene inserito, false altrimenti
+*/
+
+bool insert_into_day_bitmap(day_bitmap_t *day, const char *start_time, const char *end_time)
+{
+    int start_sec, end_sec;
+
+    if (parse_daytime(start_time, &start_sec, NULL) != TIME_STRING_OK || parse_daytime(end_time, &end_sec, NULL) != TIME_STRING_OK)
+        return false;
+
+    return _day_bitmap_insert_sec(day, start_sec, end_sec);
+}
+
+/*inizializza una programmazione giornaliera vuota*/
+
+void init_day_bitmap(day_bitmap_t *day)
+{
+    memset(day->words, 0, sizeof(day->words));
+}
+
+/*stampa su stringa la programmazione giornaliera come lista di intervalli HH:MM/HH:MM, ritorna il numero di caratteri scritti*/
+
+int sprint_day_bitmap(const day_bitmap_t *day, char *dest, const int destsize)
+{
+    int offset = 0;
+    int start = _day_bitmap_find(day, 0, true);
+
+    if (destsize < 13)
+        return 0;
+
+    while (start < MINUTES_PER_DAY && destsize - offset >= (offset ? 14 : 12))     //spazio per separatore, intervallo e terminatore
+    {
+        int end = _day_bitmap_find(day, start, false);
+
+        if (offset)
+        {
+            dest[offset++] = ',';
+            dest[offset++] = ' ';
+        }
+        offset += _sprint_interval(dest + offset, start, end);
+        start = _day_bitmap_find(day, end, true);
+    }
+
+    dest[offset] = '\0';
+    return offset;
+}
+
+/*verifica se un orario dato è compreso nella programmazione giornaliera*/
+
+bool time_in_day_bitmap(const struct tm *test_time, const day_bitmap_t *day)
+{
+    int minute = test_time->tm_hour * MINUTES_PER_HOUR + test_time->tm_min;
+
+    if (minute < 0 || minute >= MINUTES_PER_DAY)
+        return false;
+
+    return _day_bitmap_test(day, minute);
+}
+
+/*
+  PROGRAMMAZIONE SETTIMANALE
+  ogni modifica di un giorno ricostruisce solo la tabella dei cambi di stato di quel giorno e del successivo,
+  il cui eventuale cambio di stato a mezzanotte dipende dall'ultimo minuto del giorno modificato
+*/
+
+/*ricostruisce la tabella ordinata dei cambi di stato di un giorno*/
+
+static void _week_prog_rebuild_transitions(week_prog_t *week, int day)
+{
+    const day_bitmap_t *prev = &week->days[(day + DAYS_PER_WEEK - 1) % DAYS_PER_WEEK];
+    bool state = _day_bitmap_test(prev, MINUTES_PER_DAY - 1);
+    int minute = 0;
+    int count = 0;
+
+    for (;;)
+    {
+        minute = _day_bitmap_find(&week->days[day], minute, !state);
+        if (minute == MINUTES_PER_DAY)
+            break;
+
+        if (count == DAY_TRANSITIONS_MAX)
+        {
+            count = DAY_TRANSITIONS_OVERFLOW;
+            break;
+        }
+
+        week->transitions[day][count++] = minute;
+        state = !state;
+    }
+
+    week->transitions_count[day] = count;
+}
+
+/*ritorna il primo cambio di stato del giorno a partire dal minuto from, MINUTES_PER_DAY se non esiste*/
+
+static int _week_prog_find_transition(const week_prog_t *week, int day, int from)
+{
+    int count = week->transitions_count[day];
+    int low = 0;
+
+    if (from >= MINUTES_PER_DAY)
+        return MINUTES_PER_DAY;
+
+    //tabella non disponibile per troppi intervalli, ricerca diretta sulla bitmap
+    if (count == DAY_TRANSITIONS_OVERFLOW)
+    {
+        bool state = from ? _day_bitmap_test(&week->days[day], from - 1) : _day_bitmap_test(&week->days[(day + DAYS_PER_WEEK - 1) % DAYS_PER_WEEK], MINUTES_PER_DAY - 1);
+        return _day_bitmap_find(&week->days[day], from, !state);
+    }
+
+    //ricerca binaria del primo cambio di stato >= from
+    while (low < count)
+    {
+        int mid = (low + count) / 2;
+        if (week->transitions[day][mid] < from)
+            low = mid + 1;
+        else
+            count = mid;
+    }
+
+    return low < week->transitions_count[day] ? week->transitions[day][low] : MINUTES_PER_DAY;
+}
+
+/*inizializza una programmazione settimanale vuota*/
+
+void init_week_prog(week_prog_t *week)
+{
+    for (int i = 0; i < DAYS_PER_WEEK; i++)
+    {
+        init_day_bitmap(&week->days[i]);
+        week->transitions_count[i] = 0;
+        week->rendered_dirty[i] = true;
+    }
+}
+
+/*inserisce un intervallo nella programmazione di un giorno della settimana (0 = domenica), ritorna true se l'intervallo viene inserito.
+  l'inserimento viene rifiutato se il giorno supererebbe RENDERED_INTERVALS_PER_DAY intervalli distinti*/
+
+bool insert_into_week_prog(week_prog_t *week, const int day, const char *start_time, const char *end_time)
+{
+    day_bitmap_t updated;
+
+    if (day < 0 || day >= DAYS_PER_WEEK)
+        return false;
+
+    updated = week->days[day];
+    if (!insert_into_day_bitmap(&updated, start_time, end_time) || _day_bitmap_runs(&updated) > RENDERED_INTERVALS_PER_DAY)
+        return false;
+
+    week->days[day] = updated;
+
+    _week_prog_rebuild_transitions(week, day);
+    _week_prog_rebuild_transitions(week, (day + 1) % DAYS_PER_WEEK);
+    week->rendered_dirty[day] = true;
+    return true;
+}
+
+/*elimina la programmazione di un giorno della settimana*/
+
+void clear_week_prog_day(week_prog_t *week, const int day)
+{
+    if (day < 0 || day >= DAYS_PER_WEEK)
+        return;
+
+    init_day_bitmap(&week->days[day]);
+    _week_prog_rebuild_transitions(week, day);
+    _week_prog_rebuild_transitions(week, (day + 1) % DAYS_PER_WEEK);
+    week->rendered_dirty[day] = true;
+}
+
+/*sostituisce in blocco la programmazione dei giorni con lista di intervalli non NULL (indice 0 = domenica),
+  la modifica è atomica: se anche una sola lista non è valida o supera RENDERED_INTERVALS_PER_DAY intervalli distinti
+  la programmazione resta invariata e ritorna false
+*/
+
+bool load_week_prog(week_prog_t *week, const char *const day_intervals[DAYS_PER_WEEK])
+{
+    day_bitmap_t parsed;
+
+    for (int i = 0; i < DAYS_PER_WEEK; i++)
+    {
+        if (!day_intervals[i])
+            continue;
+
+        init_day_bitmap(&parsed);
+        if (!_parse_interval_list(day_intervals[i], &parsed) || _day_bitmap_runs(&parsed) > RENDERED_INTERVALS_PER_DAY)
+            return false;
+    }
+
+    for (int i = 0; i < DAYS_PER_WEEK; i++)
+    {
+        if (day_intervals[i])
+        {
+            init_day_bitmap(&week->days[i]);
+            _parse_interval_list(day_intervals[i], &week->days[i]);
+            week->rendered_dirty[i] = true;
+        }
+    }
+
+    for (int i = 0; i < DAYS_PER_WEEK; i++)
+        _week_prog_rebuild_transitions(week, i);
+
+    return true;
+}
+
+/*intervalli programmati del giorno come coppie inizio / fine in minuti, ritorna il numero di valori scritti
+  o -1 se gli intervalli non entrano in max valori*/
+
+int week_prog_day_runs(const week_prog_t *week, const int day, uint16_t *runs, const int max)
+{
+    int count = 0;
+    int start = _day_bitmap_find(&week->days[day], 0, true);
+
+    while (start < MINUTES_PER_DAY)
+    {
+        int end = _day_bitmap_find(&week->days[day], start, false);
+
+        if (count + 2 > max)
+            return -1;
+
+        runs[count++] = start;
+        runs[count++] = end;
+        start = _day_bitmap_find(&week->days[day], end, true);
+    }
+
+    return count;
+}
+
+/*sostituisce la programmazione del giorno con coppie inizio / fine in minuti crescenti e non sovrapposte, al più
+  RENDERED_INTERVALS_PER_DAY coppie. se le coppie non sono valide la programmazione resta invariata e ritorna false*/
+
+bool set_week_prog_day_runs(week_prog_t *week, const int day, const uint16_t *runs, const int count)
+{
+    int previous_end = 0;
+
+    if (day < 0 || day >= DAYS_PER_WEEK || count < 0 || count % 2 || count > 2 * RENDERED_INTERVALS_PER_DAY)
+        return false;
+
+    for (int i = 0; i < count; i += 2)
+    {
+        if (runs[i] < previous_end || runs[i] >= runs[i + 1] || runs[i + 1] > MINUTES_PER_DAY)
+            return false;
+        previous_end = runs[i + 1];
+    }
+
+    init_day_bitmap(&week->days[day]);
+    for (int i = 0; i < count; i += 2)
+        _day_bitmap_fill(&week->days[day], runs[i], runs[i + 1], true);
+
+    _week_prog_rebuild_transitions(week, day);
+    _week_prog_rebuild_transitions(week, (day + 1) % DAYS_PER_WEEK);
+    week->rendered_dirty[day] = true;
+    return true;
+}
+
+/*ritorna la stringa della programmazione di un giorno della settimana, rigenerandola solo se il giorno è stato modificato.
+  il flag viene azzerato prima della generazione, per cui una modifica concorrente lo risetta e non va persa;
+  l'accesso concorrente alla programmazione va comunque serializzato dal chiamante*/
+
+const char *week_prog_day_string(week_prog_t *week, const int day)
+{
+    if (week->rendered_dirty[day])
+    {
+        week->rendered_dirty[day] = false;
+        sprint_day_bitmap(&week->days[day], week->rendered[day], DAY_PROG_STRING_SIZE);
+    }
+
+    return week->rendered[day];
+}
+
+/*verifica se un orario dato è compreso nella programmazione del suo giorno della settimana*/
+
+bool time_in_week_prog(const week_prog_t *week, const struct tm *test_time)
+{
+    if (test_time->tm_wday < 0 || test_time->tm_wday >= DAYS_PER_WEEK)
+        return false;
+
+    return time_in_day_bitmap(test_time, &week->days[test_time->tm_wday]);
+}
+
+/*ritorna l'istante del primo cambio di stato della programmazione successivo al minuto di after, (time_t)-1 se la programmazione non cambia mai stato*/
+
+time_t next_transition_after(const week_prog_t *week, time_t after)
+{
+    struct tm edge_time;
+
+    localtime_r(&after, &edge_time);
+
+    //giorno corrente dal minuto successivo, poi i giorni seguenti fino allo stesso giorno della settimana successiva
+    for (int i = 0; i <= DAYS_PER_WEEK; i++)
+    {
+        int day = (edge_time.tm_wday + i) % DAYS_PER_WEEK;
+        int edge = _week_prog_find_transition(week, day, i == 0 ? edge_time.tm_hour * MINUTES_PER_HOUR + edge_time.tm_min + 1 : 0);
+
+        if (edge < MINUTES_PER_DAY)
+        {
+            edge_time.tm_mday += i;
+            edge_time.tm_hour = edge / MINUTES_PER_HOUR;
+            edge_time.tm_min = edge % MINUTES_PER_HOUR;
+            edge_time.tm_sec = 0;
+            edge_time.tm_isdst = -1;
+            return mktime(&edge_time);
+        }
+    }
+
+    return (time_t)-1;
+}
@@ -2,11 +2,22 @@
 #define _TIMEINTERVAL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 #define SECONDS_PER_DAY 86400
 #define SECONDS_PER_HOUR 3600
 #define SECONDS_PER_MINUTE 60
+#define MINUTES_PER_HOUR 60
+#define MINUTES_PER_DAY 1440
+
+#define DAYS_PER_WEEK 7
+
+#define DAY_BITMAP_WORDS (MINUTES_PER_DAY / 32)    //45 word da 32 bit, un bit per ogni minuto della giornata
+#define DAY_TRANSITIONS_MAX 48                      //cambi di stato indicizzati per giorno, oltre si ricorre alla scansione della bitmap
+#define DAY_TRANSITIONS_OVERFLOW 0xFF
+#define RENDERED_INTERVALS_PER_DAY 24                                   //numero massimo di intervalli giornalieri, le modifiche che lo superano vengono rifiutate
+#define DAY_PROG_STRING_SIZE (13 * RENDERED_INTERVALS_PER_DAY)
 
 #define IS_FREE_BOX(daytime_interval_sec_t) ((daytime_interval_sec_t.start_sec == INT_MAX) || (daytime_interval_sec_t.end_sec == INT_MAX))
 
@@ -16,9 +27,44 @@ typedef struct
     int end_sec;
 } daytime_interval_sec_t;
 
+/*programmazione giornaliera al minuto: il bit n è a 1 se il minuto n della giornata è programmato*/
+
+typedef struct
+{
+    uint32_t words[DAY_BITMAP_WORDS];
+} day_bitmap_t;
+
+/*programmazione settimanale con tabella ordinata dei cambi di stato (inizio e fine intervallo) per ogni giorno,
+  i cambi di stato a mezzanotte tengono conto del giorno precedente.
+  la stringa di ogni giorno viene conservata e rigenerata solo se il giorno è stato modificato*/
+
+typedef struct
+{
+    day_bitmap_t days[DAYS_PER_WEEK];
+    uint16_t transitions[DAYS_PER_WEEK][DAY_TRANSITIONS_MAX];
+    uint8_t transitions_count[DAYS_PER_WEEK];
+    char rendered[DAYS_PER_WEEK][DAY_PROG_STRING_SIZE];
+    bool rendered_dirty[DAYS_PER_WEEK];
+} week_prog_t;
+
 bool insert_into_interval_array(daytime_interval_sec_t arr[], const char *start_time, const char *end_time, const int size);
 void init_interval_array(daytime_interval_sec_t arr[], int size);
 int sprint_intervals(const daytime_interval_sec_t arr[], const int arrsize, char *dest, const int destsize);
 bool time_in_interval(const struct tm *test_time, const daytime_interval_sec_t arr[], const int arrsize);
 
+bool insert_into_day_bitmap(day_bitmap_t *day, const char *start_time, const char *end_time);
+void init_day_bitmap(day_bitmap_t *day);
+int sprint_day_bitmap(const day_bitmap_t *day, char *dest, const int destsize);
+bool time_in_day_bitmap(const struct tm *test_time, const day_bitmap_t *day);
+
+void init_week_prog(week_prog_t *week);
+bool insert_into_week_prog(week_prog_t *week, const int day, const char *start_time, const char *end_time);
+void clear_week_prog_day(week_prog_t *week, const int day);
+bool load_week_prog(week_prog_t *week, const char *const day_intervals[DAYS_PER_WEEK]);
+int week_prog_day_runs(const week_prog_t *week, const int day, uint16_t *runs, const int max);
+bool set_week_prog_day_runs(week_prog_t *week, const int day, const uint16_t *runs, const int count);
+const char *week_prog_day_string(week_prog_t *week, const int day);
+bool time_in_week_prog(const week_prog_t *week, const struct tm *test_time);
+time_t next_transition_after(const week_prog_t *week, time_t after);
+
 #endif
\ No newline at end of file
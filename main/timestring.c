@@ -0,0 +1,70 @@
+#include <stddef.h>
+#include "timestring.h"
+
+#define _MAX_DAYTIME_HOUR 24
+
+/*converte due cifre decimali in un intero, ritorna -1 se i caratteri non sono cifre*/
+
+static int _two_digits(const char *str)
+{
+    if (str[0] < '0' || str[0] > '9' || str[1] < '0' || str[1] > '9')
+        return -1;
+
+    return (str[0] - '0') * 10 + (str[1] - '0');
+}
+
+/*analizza un orario nel formato HH:MM o HH:MM:SS con due cifre per campo e lo converte in secondi dalla mezzanotte,
+  24:00 e 24:00:00 sono ammessi come fine giornata.
+  se endptr non è NULL vi viene scritto il puntatore al primo carattere non analizzato, altrimenti la stringa deve terminare dopo l'orario
+*/
+
+time_string_err_t parse_daytime(const char *str, int *sec, const char **endptr)
+{
+    int hour, min, seconds = 0;
+
+    if (!str || !sec)
+        return TIME_STRING_ERR_NULL;
+
+    hour = _two_digits(str);
+    if (hour < 0 || str[2] != ':')
+        return TIME_STRING_ERR_FORMAT;
+
+    min = _two_digits(str + 3);
+    if (min < 0)
+        return TIME_STRING_ERR_FORMAT;
+
+    str += 5;
+
+    if (str[0] == ':')
+    {
+        seconds = _two_digits(str + 1);
+        if (seconds < 0)
+            return TIME_STRING_ERR_FORMAT;
+        str += 3;
+    }
+
+    if (endptr)
+        *endptr = str;
+    else if (str[0] != '\0')
+        return TIME_STRING_ERR_FORMAT;
+
+    if (hour > _MAX_DAYTIME_HOUR || min > 59 || seconds > 59 || (hour == _MAX_DAYTIME_HOUR && (min != 0 || seconds != 0)))
+        return TIME_STRING_ERR_RANGE;
+
+    *sec = hour * 3600 + min * 60 + seconds;
+    return TIME_STRING_OK;
+}
+
+/*scrive l'orario nel formato HH:MM senza terminatore di stringa, minute_of_day deve essere compreso tra 0 e 1440 (24:00)*/
+
+void format_daytime_hhmm(int minute_of_day, char *dest)
+{
+    int hour = minute_of_day / 60;
+    int min = minute_of_day % 60;
+
+    dest[0] = '0' + hour / 10;
+    dest[1] = '0' + hour % 10;
+    dest[2] = ':';
+    dest[3] = '0' + min / 10;
+    dest[4] = '0' + min % 10;
+}
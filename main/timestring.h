@@ -0,0 +1,17 @@
+#ifndef _TIMESTRING_H
+#define _TIMESTRING_H
+
+#define DAYTIME_HHMM_LENGTH 5      //lunghezza della stringa HH:MM senza terminatore
+
+typedef enum
+{
+    TIME_STRING_OK = 0,
+    TIME_STRING_ERR_NULL,       //stringa o destinazione NULL
+    TIME_STRING_ERR_FORMAT,     //formato diverso da HH:MM o HH:MM:SS
+    TIME_STRING_ERR_RANGE       //ore, minuti o secondi fuori intervallo
+} time_string_err_t;
+
+time_string_err_t parse_daytime(const char *str, int *sec, const char **endptr);
+void format_daytime_hhmm(int minute_of_day, char *dest);
+
+#endif
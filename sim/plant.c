@@ -0,0 +1,108 @@
+#include <math.h>
+
+#include "plant.h"
+
+#define _PLANT_SECONDS_PER_DAY 86400.0
+#define _PLANT_DAYS_PER_YEAR 365.25
+#define _PLANT_COLDEST_DAY 15                   //giorno dell'anno più freddo, metà gennaio
+#define _PLANT_WARMEST_HOUR 15
+#define _PLANT_WEATHER_STEP_S 3600              //aggiornamento della componente meteo
+#define _PLANT_WEATHER_PERSISTENCE 0.96         //correlazione oraria, fronti di circa un giorno
+
+/*appartamento di circa 70 m² in classe energetica media: a 0°C esterni e 20°C interni disperde circa 3 kW,
+  la caldaia da 8 kW porta il radiatore circa 45°C sopra la stanza e scalda la stanza di circa 2°C all'ora*/
+
+const plant_params_t plant_default_params = {
+    .room_capacity_j_k = 8.0e6,
+    .envelope_w_k = 150.0,
+    .radiator_capacity_j_k = 2.0e5,
+    .radiator_w_k = 180.0,
+    .heater_w = 8000.0,
+    .internal_gain_w = 300.0,
+};
+
+/*zone climatiche c, e ed f: costa tirrenica, pianura padana, valle alpina*/
+
+const outdoor_profile_t outdoor_profiles[] = {
+    {.name = "coastal", .mean_c = 15.5, .annual_amplitude_c = 8.5, .daily_amplitude_c = 4.5, .weather_sd_c = 2.0, .heating_from = 1115, .heating_to = 331},
+    {.name = "padana", .mean_c = 13.0, .annual_amplitude_c = 11.0, .daily_amplitude_c = 5.0, .weather_sd_c = 2.5, .heating_from = 1015, .heating_to = 415},
+    {.name = "alpine", .mean_c = 6.0, .annual_amplitude_c = 10.5, .daily_amplitude_c = 6.5, .weather_sd_c = 3.5, .heating_from = 1001, .heating_to = 515},
+};
+
+const int outdoor_profiles_count = sizeof(outdoor_profiles) / sizeof(outdoor_profiles[0]);
+
+void plant_init(plant_t *plant, double temp)
+{
+    plant->room = temp;
+    plant->radiator = temp;
+}
+
+/*integrazione di eulero di dt_s secondi, stabile per passi molto più brevi delle costanti di tempo
+  (radiatore circa 18 minuti, stanza circa 15 ore)*/
+
+void plant_step(plant_t *plant, const plant_params_t *params, bool heating, double outdoor_c, double dt_s)
+{
+    double to_room_w = (plant->radiator - plant->room) * params->radiator_w_k;
+    double to_outdoor_w = (plant->room - outdoor_c) * params->envelope_w_k;
+
+    plant->radiator += ((heating ? params->heater_w : 0.0) - to_room_w) * dt_s / params->radiator_capacity_j_k;
+    plant->room += (to_room_w + params->internal_gain_w - to_outdoor_w) * dt_s / params->room_capacity_j_k;
+}
+
+static double _outdoor_uniform(outdoor_t *outdoor)
+{
+    outdoor->random_state ^= outdoor->random_state << 13;
+    outdoor->random_state ^= outdoor->random_state >> 17;
+    outdoor->random_state ^= outdoor->random_state << 5;
+    return (outdoor->random_state + 0.5) / 4294967296.0;
+}
+
+/*campione gaussiano con il metodo di box-muller*/
+
+static double _outdoor_gaussian(outdoor_t *outdoor)
+{
+    double u = _outdoor_uniform(outdoor);
+    double v = _outdoor_uniform(outdoor);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+void outdoor_init(outdoor_t *outdoor, const outdoor_profile_t *profile, uint32_t seed)
+{
+    outdoor->profile = profile;
+    outdoor->weather_c = 0.0;
+    outdoor->weather_updated = 0;
+    outdoor->random_state = seed ? seed : 1;
+}
+
+/*temperatura esterna all'istante now, da chiamare con istanti crescenti*/
+
+double outdoor_temp(outdoor_t *outdoor, time_t now)
+{
+    const outdoor_profile_t *profile = outdoor->profile;
+    double innovation = profile->weather_sd_c * sqrt(1.0 - _PLANT_WEATHER_PERSISTENCE * _PLANT_WEATHER_PERSISTENCE);
+    double day = fmod((double)now / _PLANT_SECONDS_PER_DAY, _PLANT_DAYS_PER_YEAR);
+    double hour = fmod((double)now, _PLANT_SECONDS_PER_DAY) / 3600.0;
+
+    while (now - outdoor->weather_updated >= _PLANT_WEATHER_STEP_S)
+    {
+        outdoor->weather_c = _PLANT_WEATHER_PERSISTENCE * outdoor->weather_c + innovation * _outdoor_gaussian(outdoor);
+        outdoor->weather_updated = outdoor->weather_updated ? outdoor->weather_updated + _PLANT_WEATHER_STEP_S : now;
+    }
+
+    return profile->mean_c
+           - profile->annual_amplitude_c * cos(2.0 * M_PI * (day - _PLANT_COLDEST_DAY) / _PLANT_DAYS_PER_YEAR)
+           + profile->daily_amplitude_c * cos(2.0 * M_PI * (hour - _PLANT_WARMEST_HOUR) / 24.0)
+           + outdoor->weather_c;
+}
+
+/*giorno compreso nel periodo di riscaldamento, che può scavalcare la fine dell'anno*/
+
+bool outdoor_heating_season(const outdoor_profile_t *profile, const struct tm *local)
+{
+    int date = (local->tm_mon + 1) * 100 + local->tm_mday;
+
+    if (profile->heating_from <= profile->heating_to)
+        return date >= profile->heating_from && date <= profile->heating_to;
+    return date >= profile->heating_from || date <= profile->heating_to;
+}
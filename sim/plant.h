@@ -0,0 +1,61 @@
+#ifndef _PLANT_H
+#define _PLANT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/*modello termico della stanza riscaldata per il simulatore: due nodi rc, il corpo scaldante (acqua e metallo del
+  radiatore) riscaldato dalla caldaia quando il relè è acceso, e la stanza (aria, muri interni e arredi) che riceve
+  calore dal radiatore e dagli apporti interni e lo perde verso l'esterno attraverso l'involucro. temperature in °C*/
+
+typedef struct
+{
+    double room_capacity_j_k;       //capacità termica della stanza
+    double envelope_w_k;            //dispersione dell'involucro verso l'esterno
+    double radiator_capacity_j_k;   //capacità termica del corpo scaldante
+    double radiator_w_k;            //scambio tra radiatore e stanza
+    double heater_w;                //potenza della caldaia con relè acceso
+    double internal_gain_w;         //apporti interni costanti (persone, elettrodomestici)
+} plant_params_t;
+
+typedef struct
+{
+    double room;
+    double radiator;
+} plant_t;
+
+/*profilo della temperatura esterna: andamento annuale con minimo a metà gennaio, andamento giornaliero con massimo
+  alle 15 e deviazione meteo lenta, casuale con seme fisso. il periodo di riscaldamento è quello della zona climatica,
+  date come mese * 100 + giorno*/
+
+typedef struct
+{
+    const char *name;
+    double mean_c;
+    double annual_amplitude_c;
+    double daily_amplitude_c;
+    double weather_sd_c;            //deviazione standard della componente meteo
+    int heating_from;               //inizio del periodo di riscaldamento, es. 1015 per il 15 ottobre
+    int heating_to;                 //ultimo giorno del periodo di riscaldamento
+} outdoor_profile_t;
+
+typedef struct
+{
+    const outdoor_profile_t *profile;
+    double weather_c;
+    time_t weather_updated;
+    uint32_t random_state;
+} outdoor_t;
+
+extern const plant_params_t plant_default_params;
+extern const outdoor_profile_t outdoor_profiles[];
+extern const int outdoor_profiles_count;
+
+void plant_init(plant_t *plant, double temp);
+void plant_step(plant_t *plant, const plant_params_t *params, bool heating, double outdoor_c, double dt_s);
+void outdoor_init(outdoor_t *outdoor, const outdoor_profile_t *profile, uint32_t seed);
+double outdoor_temp(outdoor_t *outdoor, time_t now);
+bool outdoor_heating_season(const outdoor_profile_t *profile, const struct tm *local);
+
+#endif
@@ -0,0 +1,400 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "optimumstart.h"
+#include "platform_posix.h"
+#include "plant.h"
+#include "sensorfilter.h"
+#include "thermocontrol.h"
+#include "thermoloop.h"
+#include "timeinterval.h"
+
+/*
+  SIMULATORE SU HOST
+  la logica del termostato (thermoloop.c, thermocontrol.c, optimumstart.c, timeinterval.c, sensorfilter.c) gira sulla piattaforma
+  simulata platform_posix.c contro il modello termico di plant.c, in tempo virtuale, per un anno o per il numero di
+  giorni indicato. ogni combinazione di clima esterno, regolazione e avvio anticipato è una simulazione indipendente,
+  eseguite in parallelo su più thread. per ogni simulazione vengono stampati comfort, energia e cambi di stato del relè.
+  l'interruttore generale è acceso solo nel periodo di riscaldamento della zona climatica, a cui si riferiscono anche
+  le statistiche di comfort: senza raffrescamento le ore estive sopra la temperatura target non dipendono dal termostato.
+
+  il ciclo riproduce thermo_task e measure_task: misura allo scoccare di ogni minuto attraverso il filtro del sensore,
+  valutazione del termostato con thermo_loop_evaluate, la stessa di thermo_task, ad ogni misura, ad ogni cambio di
+  stato della programmazione e alle scadenze della tpi.
+
+  uso: thermosim [-d giorni] [-j thread] [-p profilo]
+*/
+
+#define SIM_STEP_S 10                   //passo di integrazione del modello e risoluzione delle scadenze
+#define SIM_MEASURE_PERIOD_S 60
+#define SIM_START_YEAR 2025
+#define SIM_TIMEZONE "CET-1CEST,M3.5.0,M10.5.0/3"
+#define SIM_SENSOR_NOISE_C 0.05         //rumore della misura, deviazione standard
+#define SIM_COMFORT_BELOW_C 0.5         //banda di comfort attorno alla temperatura target durante gli intervalli programmati
+#define SIM_COMFORT_ABOVE_C 1.0
+#define SIM_SHORT_RUN_S 300             //accensioni più brevi contano come cicli corti
+#define SIM_OPTIMUM_START_MAX_LEAD_S (180 * SECONDS_PER_MINUTE)
+#define SIM_OPTIMUM_START_MIN_RUN_S (20 * SECONDS_PER_MINUTE)
+
+/*programmazione dei giorni feriali e del fine settimana, indice 0 = domenica*/
+
+static const char *const sim_week_prog[DAYS_PER_WEEK] = {
+    "08:00/23:00",
+    "06:30/08:30, 17:30/22:30",
+    "06:30/08:30, 17:30/22:30",
+    "06:30/08:30, 17:30/22:30",
+    "06:30/08:30, 17:30/22:30",
+    "06:30/08:30, 17:30/22:30",
+    "08:00/23:00",
+};
+
+typedef struct
+{
+    const char *name;
+    thermo_control_mode_t mode;
+    int16_t delta_temp;             //isteresi, in decimi
+    thermo_tpi_params_t tpi;
+} sim_controller_t;
+
+static const sim_controller_t sim_controllers[] = {
+    {.name = "hysteresis 0.2", .mode = THERMO_CONTROL_HYSTERESIS, .delta_temp = 2},
+    {.name = "hysteresis 0.5", .mode = THERMO_CONTROL_HYSTERESIS, .delta_temp = 5},
+    {.name = "hysteresis 1.0", .mode = THERMO_CONTROL_HYSTERESIS, .delta_temp = 10},
+    {.name = "tpi 10m kp50 ki25", .mode = THERMO_CONTROL_TPI, .tpi = {600, 50, 25, 120, 120}},
+    {.name = "tpi 10m kp100 ki50", .mode = THERMO_CONTROL_TPI, .tpi = {600, 100, 50, 120, 120}},
+    {.name = "tpi 10m kp200 ki100", .mode = THERMO_CONTROL_TPI, .tpi = {600, 200, 100, 120, 120}},
+    {.name = "tpi 15m kp100 ki50", .mode = THERMO_CONTROL_TPI, .tpi = {900, 100, 50, 180, 180}},
+};
+
+#define SIM_CONTROLLERS_COUNT (int)(sizeof(sim_controllers) / sizeof(sim_controllers[0]))
+
+typedef struct
+{
+    const outdoor_profile_t *profile;
+    const sim_controller_t *controller;
+    bool optimum_start;
+    int days;
+    uint32_t seed;
+} sim_config_t;
+
+typedef struct
+{
+    double energy_kwh;
+    double occupied_h;
+    double comfort_h;               //ore programmate nella banda di comfort
+    double underheat_kh;            //gradi ora sotto la banda di comfort durante gli intervalli programmati
+    double overheat_kh;             //gradi ora sopra la banda di comfort durante gli intervalli programmati
+    double late_start_min;          //ritardo medio all'inizio degli intervalli prima di entrare nella banda di comfort
+    double min_room_c;
+    double season_h;                //ore del periodo di riscaldamento
+    double outdoor_mean_c;          //media esterna nel periodo di riscaldamento
+    uint32_t switches;
+    uint32_t short_runs;
+    uint32_t evaluations;
+    double elapsed_s;
+} sim_result_t;
+
+typedef struct
+{
+    const sim_config_t *configs;
+    sim_result_t *results;
+    int count;
+    int next;                       //prossima simulazione da eseguire, condivisa tra i thread
+} sim_queue_t;
+
+static double sim_gaussian(void)
+{
+    double u = (platform_random() + 0.5) / 4294967296.0;
+    double v = (platform_random() + 0.5) / 4294967296.0;
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static time_t sim_start_time(void)
+{
+    struct tm start = {.tm_year = SIM_START_YEAR - 1900, .tm_mon = 0, .tm_mday = 1, .tm_isdst = -1};
+
+    return mktime(&start);
+}
+
+/*una simulazione completa, sullo stato della piattaforma del thread corrente*/
+
+static void sim_run(const sim_config_t *config, sim_result_t *result)
+{
+    const plant_params_t *params = &plant_default_params;
+    thermo_state_t state = {.target_temp = 200, .base_temp = 120, .prog_switch = true};
+    week_prog_t week_prog;
+    sensor_filter_t filter;
+    thermo_loop_t loop;
+    thermo_loop_result_t loop_result = {.tpi_pending = false, .next_wakeup = (time_t)-1};
+    optimum_start_model_t model;
+    plant_t plant;
+    outdoor_t outdoor;
+    time_t start = sim_start_time();
+    time_t end = start + (time_t)config->days * SECONDS_PER_DAY;
+    uint32_t run_start = 0;
+    double target_c = state.target_temp / 10.0;
+    double outdoor_sum = 0.0;
+    double late_sum_min = 0.0;
+    uint32_t late_count = 0;
+    time_t interval_start = 0;
+    bool waiting_comfort = false;
+    bool occupied_before = false;
+    bool relay_before = false;
+    bool evaluate;
+    struct timespec wall_start, wall_end;
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    memset(result, 0, sizeof(*result));
+    result->min_room_c = 100.0;
+
+    state.delta_temp = config->controller->delta_temp;
+    state.control_mode = config->controller->mode;
+    init_week_prog(&week_prog);
+    load_week_prog(&week_prog, sim_week_prog);
+    sensor_filter_init(&filter);
+    optimum_start_init(&model);
+    thermo_loop_init(&loop, &config->controller->tpi, config->optimum_start ? &model : NULL, SIM_OPTIMUM_START_MAX_LEAD_S, SIM_OPTIMUM_START_MIN_RUN_S);
+    outdoor_init(&outdoor, config->profile, config->seed);
+
+    platform_posix_reset(start);
+    platform_posix_seed_random(config->seed);
+    platform_setup();
+    plant_init(&plant, target_c);
+
+    for (time_t now = start; now < end; now += SIM_STEP_S)
+    {
+        uint32_t uptime = (uint32_t)(platform_uptime_us() / 1000000);
+        double outdoor_c = outdoor_temp(&outdoor, now);
+        struct tm local;
+        bool occupied;
+        bool season;
+
+        localtime_r(&now, &local);
+        season = outdoor_heating_season(config->profile, &local);
+        occupied = season && time_in_week_prog(&week_prog, &local);
+        evaluate = season != state.main_switch;     //accensione o spegnimento dell'impianto a inizio e fine stagione
+        state.main_switch = season;
+
+        //measure_task: una misura al minuto attraverso il filtro del sensore
+        if (now % SIM_MEASURE_PERIOD_S == 0)
+        {
+            dht_reading_t reading;
+            int16_t temp, humi;
+
+            platform_posix_set_sensor(0, (int16_t)lround((plant.room + SIM_SENSOR_NOISE_C * sim_gaussian()) * 10.0), 500, true);
+            if (platform_sensors_read(&reading) > 0)
+                sensor_filter_push(&filter, reading.temp, reading.humi, uptime);
+            state.dht_ok = sensor_filter_output(&filter, &temp, &humi);
+            if (state.dht_ok)
+                state.current_temp = temp;
+            evaluate = true;
+        }
+
+        //risvegli del thermo_task per la programmazione e per la tpi
+        if (loop_result.next_wakeup != (time_t)-1 && now >= loop_result.next_wakeup)
+            evaluate = true;
+        if (loop_result.tpi_pending && loop_result.tpi_next_event <= uptime)
+            evaluate = true;
+
+        if (evaluate)
+        {
+            thermo_loop_evaluate(&loop, &state, time_in_week_prog(&week_prog, &local), next_transition_after(&week_prog, now), now, uptime, &loop_result);
+            platform_relay_set(loop_result.relay_on);
+            state.thermo_on = loop_result.relay_on;
+            result->evaluations++;
+        }
+
+        //statistiche sul passo appena trascorso
+        if (platform_posix_relay() && !relay_before)
+            run_start = uptime;
+        else if (!platform_posix_relay() && relay_before && uptime - run_start < SIM_SHORT_RUN_S)
+            result->short_runs++;
+        relay_before = platform_posix_relay();
+
+        if (occupied && !occupied_before)
+        {
+            interval_start = now;
+            waiting_comfort = true;
+        }
+        if (occupied && waiting_comfort && plant.room >= target_c - SIM_COMFORT_BELOW_C)
+        {
+            late_sum_min += (now - interval_start) / 60.0;
+            late_count++;
+            waiting_comfort = false;
+        }
+        if (!occupied && waiting_comfort)    //intervallo terminato senza raggiungere il comfort
+        {
+            late_sum_min += (now - interval_start) / 60.0;
+            late_count++;
+            waiting_comfort = false;
+        }
+        occupied_before = occupied;
+
+        if (occupied)
+        {
+            result->occupied_h += SIM_STEP_S / 3600.0;
+            if (plant.room < target_c - SIM_COMFORT_BELOW_C)
+                result->underheat_kh += (target_c - SIM_COMFORT_BELOW_C - plant.room) * SIM_STEP_S / 3600.0;
+            else if (plant.room > target_c + SIM_COMFORT_ABOVE_C)
+                result->overheat_kh += (plant.room - target_c - SIM_COMFORT_ABOVE_C) * SIM_STEP_S / 3600.0;
+            else
+                result->comfort_h += SIM_STEP_S / 3600.0;
+        }
+        if (platform_posix_relay())
+            result->energy_kwh += params->heater_w * SIM_STEP_S / 3.6e6;
+        if (season && plant.room < result->min_room_c)
+            result->min_room_c = plant.room;
+        if (season)
+        {
+            result->season_h += SIM_STEP_S / 3600.0;
+            outdoor_sum += outdoor_c;
+        }
+
+        plant_step(&plant, params, platform_posix_relay(), outdoor_c, SIM_STEP_S);
+        platform_posix_advance_us((int64_t)SIM_STEP_S * 1000000);
+    }
+
+    result->switches = platform_posix_relay_switches();
+    result->late_start_min = late_count ? late_sum_min / late_count : 0.0;
+    result->outdoor_mean_c = result->season_h > 0 ? outdoor_sum * SIM_STEP_S / 3600.0 / result->season_h : 0.0;
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    result->elapsed_s = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+}
+
+static void *sim_worker(void *arg)
+{
+    sim_queue_t *queue = arg;
+    int index;
+
+    while ((index = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED)) < queue->count)
+        sim_run(&queue->configs[index], &queue->results[index]);
+
+    return NULL;
+}
+
+static void sim_print(const sim_config_t *configs, const sim_result_t *results, int count)
+{
+    printf("%-8s %6s %-20s %-7s %9s %8s %9s %8s %7s %7s %8s %6s\n",
+           "climate", "out", "controller", "preheat", "energy", "comfort", "underheat", "overheat", "late", "min", "switches", "short");
+    printf("%-8s %6s %-20s %-7s %9s %8s %9s %8s %7s %7s %8s %6s\n",
+           "", "C", "", "", "kWh", "%", "K h", "K h", "min", "C", "", "");
+
+    for (int i = 0; i < count; i++)
+    {
+        const sim_result_t *r = &results[i];
+
+        printf("%-8s %6.1f %-20s %-7s %9.0f %8.1f %9.1f %8.1f %7.1f %7.1f %8u %6u\n",
+               configs[i].profile->name, r->outdoor_mean_c, configs[i].controller->name, configs[i].optimum_start ? "on" : "off",
+               r->energy_kwh, r->occupied_h > 0 ? 100.0 * r->comfort_h / r->occupied_h : 0.0,
+               r->underheat_kh, r->overheat_kh, r->late_start_min, r->min_room_c, (unsigned)r->switches, (unsigned)r->short_runs);
+    }
+}
+
+static void sim_usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [-d days] [-j threads] [-p profile]\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    int days = 365;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *profile_name = NULL;
+    sim_queue_t queue = {0};
+    sim_config_t *configs;
+    sim_result_t *results;
+    pthread_t *workers;
+    double cpu_s = 0.0;
+    uint64_t evaluations = 0;
+    struct timespec wall_start, wall_end;
+    int count = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:j:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd': days = atoi(optarg); break;
+        case 'j': threads = atol(optarg); break;
+        case 'p': profile_name = optarg; break;
+        default: sim_usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (days <= 0 || threads <= 0)
+    {
+        sim_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    //l'orario locale è quello del firmware, impostato una volta prima dei thread
+    setenv("TZ", SIM_TIMEZONE, 1);
+    tzset();
+
+    configs = calloc(outdoor_profiles_count * SIM_CONTROLLERS_COUNT * 2, sizeof(sim_config_t));
+    results = calloc(outdoor_profiles_count * SIM_CONTROLLERS_COUNT * 2, sizeof(sim_result_t));
+    if (!configs || !results)
+        return EXIT_FAILURE;
+
+    for (int p = 0; p < outdoor_profiles_count; p++)
+    {
+        if (profile_name && strcmp(profile_name, outdoor_profiles[p].name) != 0)
+            continue;
+
+        for (int c = 0; c < SIM_CONTROLLERS_COUNT; c++)
+        {
+            for (int preheat = 0; preheat < 2; preheat++)
+            {
+                configs[count].profile = &outdoor_profiles[p];
+                configs[count].controller = &sim_controllers[c];
+                configs[count].optimum_start = preheat;
+                configs[count].days = days;
+                configs[count].seed = 0x9E3779B9u + p;     //stesso meteo per tutte le regolazioni di un clima
+                count++;
+            }
+        }
+    }
+
+    if (count == 0)
+    {
+        fprintf(stderr, "unknown profile %s\n", profile_name);
+        return EXIT_FAILURE;
+    }
+
+    if (threads > count)
+        threads = count;
+    workers = calloc(threads, sizeof(pthread_t));
+    queue.configs = configs;
+    queue.results = results;
+    queue.count = count;
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    for (long i = 0; i < threads; i++)
+        pthread_create(&workers[i], NULL, sim_worker, &queue);
+    for (long i = 0; i < threads; i++)
+        pthread_join(workers[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+    sim_print(configs, results, count);
+
+    for (int i = 0; i < count; i++)
+    {
+        cpu_s += results[i].elapsed_s;
+        evaluations += results[i].evaluations;
+    }
+    printf("\n%d simulations of %d days on %ld threads: %.2f s wall, %.2f s cpu, %llu thermostat evaluations\n",
+           count, days, threads, (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9,
+           cpu_s, (unsigned long long)evaluations);
+
+    free(workers);
+    free(configs);
+    free(results);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include <string.h>
+
+#include "test.h"
+#include "jsonreader.h"
+#include "jsonwriter.h"
+
+/*benchmark del writer sul messaggio di stato completo pubblicato dal termostato, confrontato con lo stesso messaggio
+  composto con snprintf, e del reader su un comando con più campi. argomento: numero di messaggi, default 200000*/
+
+static const char command[] = "{\"targetTemp\":21.5,\"baseTemp\":16,\"deltaTemp\":0.3,\"mainSwitch\":true,\"progSwitch\":true,"
+                              "\"weekdaySelected\":3,\"startTime\":\"07:00\",\"endTime\":\"08:30\"}";
+
+static int write_status(char *buffer, int size, int i)
+{
+    json_writer_t writer;
+
+    json_writer_init(&writer, buffer, size);
+    json_writer_add_tenths(&writer, "currentTemp", 180 + i % 60);
+    json_writer_add_tenths(&writer, "currentHumi", 450 + i % 100);
+    json_writer_add_tenths(&writer, "targetTemp", 215);
+    json_writer_add_tenths(&writer, "baseTemp", 160);
+    json_writer_add_tenths(&writer, "deltaTemp", 3);
+    json_writer_add_bool(&writer, "mainSwitch", true);
+    json_writer_add_bool(&writer, "progSwitch", i & 1);
+    json_writer_add_bool(&writer, "relayState", i & 2);
+    json_writer_add_bool(&writer, "dhtOk", true);
+    json_writer_add_bool(&writer, "nodeOnline", true);
+    json_writer_add_string(&writer, "weekProgDay3", "07:00/08:30, 18:00/22:30");
+    return json_writer_finish(&writer);
+}
+
+/*stesso messaggio con snprintf, solo valori positivi e senza escape della stringa*/
+
+static int snprintf_status(char *buffer, int size, int i)
+{
+    int temp = 180 + i % 60, humi = 450 + i % 100;
+
+    return snprintf(buffer, size, "{\"currentTemp\":%d.%d,\"currentHumi\":%d.%d,\"targetTemp\":21.5,\"baseTemp\":16,\"deltaTemp\":0.3,"
+                    "\"mainSwitch\":true,\"progSwitch\":%s,\"relayState\":%s,\"dhtOk\":true,\"nodeOnline\":true,"
+                    "\"weekProgDay3\":\"07:00/08:30, 18:00/22:30\"}",
+                    temp / 10, temp % 10, humi / 10, humi % 10,
+                    (i & 1) ? "true" : "false", (i & 2) ? "true" : "false");
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = test_iterations(argc, argv, 200000);
+    char buffer[512];
+    long written = 0, printed = 0, members = 0;
+    uint64_t start, writer_ns, snprintf_ns, reader_ns;
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+        written += write_status(buffer, sizeof(buffer), i);
+    writer_ns = test_now_ns() - start;
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+        printed += snprintf_status(buffer, sizeof(buffer), i);
+    snprintf_ns = test_now_ns() - start;
+
+    //il reader decodifica sul posto, ogni iterazione parte da una copia del comando
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+    {
+        json_reader_t reader;
+        json_member_t member;
+
+        memcpy(buffer, command, sizeof(command));
+        json_reader_init(&reader, buffer);
+        while (json_reader_next(&reader, &member))
+            members++;
+        TEST_CHECK(!reader.error);
+    }
+    reader_ns = test_now_ns() - start;
+
+    TEST_CHECK(members == iterations * 8);
+
+    printf("%ld messages, status %ld bytes (snprintf %ld), command %d bytes\n", iterations, written / iterations, printed / iterations, (int)sizeof(command) - 1);
+    printf("%-28s %10.1f ns/msg\n", "json_writer status", (double)writer_ns / iterations);
+    printf("%-28s %10.1f ns/msg\n", "snprintf status", (double)snprintf_ns / iterations);
+    printf("%-28s %10.1f ns/msg\n", "json_reader command", (double)reader_ns / iterations);
+    return TEST_RESULT();
+}
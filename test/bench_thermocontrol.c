@@ -0,0 +1,75 @@
+#include <stdbool.h>
+
+#include "test.h"
+#include "thermocontrol.h"
+
+/*costo di una decisione del relè: logica originale in double, isteresi in decimi e regolazione tpi.
+  argomento: numero di decisioni, default 10000000*/
+
+#define SAMPLES 4096
+
+static bool baseline_thermo_step(double current_temp, double target_temp, double base_temp, double delta_temp,
+                                 bool main_switch, bool prog_switch, bool in_interval, bool *thermo_on)
+{
+    if (main_switch == true && ((prog_switch == true && in_interval) || prog_switch == false) && current_temp < target_temp)
+        *thermo_on = true;
+    else if (main_switch == true && ((prog_switch == true && in_interval) || prog_switch == false) && *thermo_on == true && current_temp <= (target_temp + delta_temp))
+        ;
+    else if (current_temp < base_temp)
+        *thermo_on = true;
+    else
+        *thermo_on = false;
+
+    return *thermo_on;
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = test_iterations(argc, argv, 10000000);
+    thermo_tpi_params_t params = {.cycle_s = 600, .kp = 100, .ki = 50, .min_on_s = 120, .min_off_s = 120};
+    thermo_tpi_t tpi;
+    static int16_t temps[SAMPLES];
+    static double temps_double[SAMPLES];
+    thermo_state_t state = {.target_temp = 210, .base_temp = 120, .delta_temp = 2, .main_switch = true, .prog_switch = true};
+    bool thermo_on = false;
+    long baseline_on = 0, relay_on = 0, tpi_on = 0;
+    uint32_t next_event;
+    uint64_t start, baseline_ns, relay_ns, tpi_ns;
+
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        temps[i] = 150 + test_random() % 100;
+        temps_double[i] = temps[i] / 10.0;
+    }
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+        baseline_on += baseline_thermo_step(temps_double[i % SAMPLES], 21.0, 12.0, 0.2, true, true, i & 256, &thermo_on);
+    baseline_ns = test_now_ns() - start;
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+    {
+        state.current_temp = temps[i % SAMPLES];
+        state.thermo_on = thermo_control_relay(&state, i & 256);
+        relay_on += state.thermo_on;
+    }
+    relay_ns = test_now_ns() - start;
+
+    thermo_tpi_init(&tpi, &params);
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+    {
+        state.current_temp = temps[i % SAMPLES];
+        tpi_on += thermo_control_tpi_relay(&tpi, &state, i & 256, (uint32_t)i, &next_event);
+    }
+    tpi_ns = test_now_ns() - start;
+
+    TEST_CHECK(baseline_on == relay_on);
+
+    printf("%ld decisions, relay on %ld (tpi %ld)\n", iterations, relay_on, tpi_on);
+    printf("%-28s %10.2f ns/op\n", "baseline double", (double)baseline_ns / iterations);
+    printf("%-28s %10.2f ns/op\n", "thermo_control_relay", (double)relay_ns / iterations);
+    printf("%-28s %10.2f ns/op\n", "thermo_control_tpi_relay", (double)tpi_ns / iterations);
+    return TEST_RESULT();
+}
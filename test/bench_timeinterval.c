@@ -0,0 +1,113 @@
+#include <string.h>
+
+#include "test.h"
+#include "timeinterval.h"
+#include "timestring.h"
+
+/*confronto tra la programmazione giornaliera a lista di intervalli e quella a bitmap: costruzione di una giornata
+  con DAY_INSERTS inserimenti, ricerca di ogni minuto della giornata e generazione della stringa.
+  argomento: numero di giornate casuali, default 2000*/
+
+#define LIST_SIZE RENDERED_INTERVALS_PER_DAY
+#define DAY_INSERTS 8
+
+typedef struct
+{
+    char start[DAY_INSERTS][8];
+    char end[DAY_INSERTS][8];
+} day_inserts_t;
+
+static void random_day(day_inserts_t *inserts)
+{
+    for (int i = 0; i < DAY_INSERTS; i++)
+    {
+        int first = test_random() % (MINUTES_PER_DAY - 1);
+        int last = first + 1 + test_random() % 120;
+
+        format_daytime_hhmm(first, inserts->start[i]);
+        format_daytime_hhmm(last < MINUTES_PER_DAY ? last : 0, inserts->end[i]);
+        inserts->start[i][DAYTIME_HHMM_LENGTH] = '\0';
+        inserts->end[i][DAYTIME_HHMM_LENGTH] = '\0';
+    }
+}
+
+static void report(const char *name, uint64_t ns, long ops)
+{
+    printf("%-28s %10.1f ns/op\n", name, (double)ns / ops);
+}
+
+int main(int argc, char **argv)
+{
+    long days = test_iterations(argc, argv, 2000);
+    day_inserts_t *inserts = malloc(days * sizeof(day_inserts_t));
+    daytime_interval_sec_t list[LIST_SIZE];
+    day_bitmap_t day;
+    char list_rendered[DAY_PROG_STRING_SIZE];
+    char day_rendered[DAY_PROG_STRING_SIZE];
+    uint64_t list_insert_ns = 0, day_insert_ns = 0;
+    uint64_t list_lookup_ns = 0, day_lookup_ns = 0;
+    uint64_t list_render_ns = 0, day_render_ns = 0;
+    long list_hits = 0, day_hits = 0;
+    uint64_t start;
+
+    if (!inserts)
+        return EXIT_FAILURE;
+
+    for (long d = 0; d < days; d++)
+        random_day(&inserts[d]);
+
+    for (long d = 0; d < days; d++)
+    {
+        start = test_now_ns();
+        init_interval_array(list, LIST_SIZE);
+        for (int i = 0; i < DAY_INSERTS; i++)
+            insert_into_interval_array(list, inserts[d].start[i], inserts[d].end[i], LIST_SIZE);
+        list_insert_ns += test_now_ns() - start;
+
+        start = test_now_ns();
+        init_day_bitmap(&day);
+        for (int i = 0; i < DAY_INSERTS; i++)
+            insert_into_day_bitmap(&day, inserts[d].start[i], inserts[d].end[i]);
+        day_insert_ns += test_now_ns() - start;
+
+        //ricerca a metà di ogni minuto, gli estremi degli intervalli danno lo stesso esito con entrambi i backend
+        start = test_now_ns();
+        for (int minute = 0; minute < MINUTES_PER_DAY; minute++)
+        {
+            struct tm t = {.tm_hour = minute / MINUTES_PER_HOUR, .tm_min = minute % MINUTES_PER_HOUR, .tm_sec = 30};
+            list_hits += time_in_interval(&t, list, LIST_SIZE);
+        }
+        list_lookup_ns += test_now_ns() - start;
+
+        start = test_now_ns();
+        for (int minute = 0; minute < MINUTES_PER_DAY; minute++)
+        {
+            struct tm t = {.tm_hour = minute / MINUTES_PER_HOUR, .tm_min = minute % MINUTES_PER_HOUR, .tm_sec = 30};
+            day_hits += time_in_day_bitmap(&t, &day);
+        }
+        day_lookup_ns += test_now_ns() - start;
+
+        start = test_now_ns();
+        sprint_intervals(list, LIST_SIZE, list_rendered, sizeof(list_rendered));
+        list_render_ns += test_now_ns() - start;
+
+        start = test_now_ns();
+        sprint_day_bitmap(&day, day_rendered, sizeof(day_rendered));
+        day_render_ns += test_now_ns() - start;
+
+        TEST_CHECK(strcmp(list_rendered, day_rendered) == 0);
+    }
+
+    TEST_CHECK(list_hits == day_hits);
+
+    printf("%ld days, %d inserts per day\n", days, DAY_INSERTS);
+    report("interval list insert", list_insert_ns, days * DAY_INSERTS);
+    report("day bitmap insert", day_insert_ns, days * DAY_INSERTS);
+    report("interval list lookup", list_lookup_ns, days * MINUTES_PER_DAY);
+    report("day bitmap lookup", day_lookup_ns, days * MINUTES_PER_DAY);
+    report("interval list render", list_render_ns, days);
+    report("day bitmap render", day_render_ns, days);
+
+    free(inserts);
+    return TEST_RESULT();
+}
@@ -0,0 +1,172 @@
+#define _XOPEN_SOURCE 700
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "test.h"
+#include "timestring.h"
+
+/*confronto tra parse_daytime e strptime("%H:%M:%S") usata in origine per gli orari degli intervalli,
+  e tra format_daytime_hhmm e snprintf: tempo per orario e picco di stack di una chiamata.
+  nessuna delle due funzioni del modulo usa dati statici. argomento: numero di orari, default 1000000*/
+
+#define SAMPLES 4096
+#define STACK_PROBE_SIZE (256 * 1024)
+#define STACK_PROBE_FILL 0xA5
+
+static const char *probe_sample = "13:47:21";
+static volatile int probe_sink;
+
+static void probe_empty(void)
+{
+}
+
+static void probe_parse_daytime(void)
+{
+    int sec = 0;
+
+    parse_daytime(probe_sample, &sec, NULL);
+    probe_sink = sec;
+}
+
+static void probe_strptime(void)
+{
+    struct tm t = {0};
+
+    strptime(probe_sample, "%H:%M:%S", &t);
+    probe_sink = t.tm_sec;
+}
+
+static void probe_format_daytime_hhmm(void)
+{
+    char formatted[16];
+
+    format_daytime_hhmm(827, formatted);
+    probe_sink = formatted[4];
+}
+
+static void probe_snprintf(void)
+{
+    char formatted[16];
+
+    snprintf(formatted, sizeof(formatted), "%02d:%02d", 827 / 60, 827 % 60);
+    probe_sink = formatted[4];
+}
+
+typedef struct
+{
+    void (*function)(void);
+} stack_probe_t;
+
+static void *stack_probe_thread(void *arg)
+{
+    ((stack_probe_t *)arg)->function();
+    return NULL;
+}
+
+/*byte di stack toccati da un thread che esegue function: lo stack del thread viene riempito con un valore noto e
+  dopo l'esecuzione si cerca il primo byte modificato, lo stack cresce verso il basso*/
+
+static size_t stack_touched(void (*function)(void))
+{
+    unsigned char *stack = malloc(STACK_PROBE_SIZE);
+    stack_probe_t probe = {function};
+    pthread_attr_t attr;
+    pthread_t thread;
+    size_t untouched = 0;
+
+    memset(stack, STACK_PROBE_FILL, STACK_PROBE_SIZE);
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, STACK_PROBE_SIZE);
+    if (pthread_create(&thread, &attr, stack_probe_thread, &probe) == 0)
+    {
+        pthread_join(thread, NULL);
+        while (untouched < STACK_PROBE_SIZE && stack[untouched] == STACK_PROBE_FILL)
+            untouched++;
+    }
+    pthread_attr_destroy(&attr);
+    free(stack);
+
+    return STACK_PROBE_SIZE - untouched;
+}
+
+/*picco di stack della chiamata, al netto dello stack usato dall'avvio del thread*/
+
+static long stack_peak(void (*function)(void))
+{
+    return (long)stack_touched(function) - (long)stack_touched(probe_empty);
+}
+
+static void report(const char *name, uint64_t ns, long ops)
+{
+    printf("%-28s %10.1f ns/op\n", name, (double)ns / ops);
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = test_iterations(argc, argv, 1000000);
+    static char samples[SAMPLES][16];
+    char formatted[16];
+    long parse_sum = 0, strptime_sum = 0;
+    uint64_t start, parse_ns, strptime_ns, format_ns, snprintf_ns;
+    volatile char sink = 0;
+
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        int s = test_random() % 86400;
+        snprintf(samples[i], sizeof(samples[i]), "%02d:%02d:%02d", s / 3600, s / 60 % 60, s % 60);
+    }
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+    {
+        int sec = 0;
+        parse_daytime(samples[i % SAMPLES], &sec, NULL);
+        parse_sum += sec;
+    }
+    parse_ns = test_now_ns() - start;
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+    {
+        struct tm t = {0};
+        strptime(samples[i % SAMPLES], "%H:%M:%S", &t);
+        strptime_sum += t.tm_hour * 3600 + t.tm_min * 60 + t.tm_sec;
+    }
+    strptime_ns = test_now_ns() - start;
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+    {
+        format_daytime_hhmm(i % 1441, formatted);
+        sink ^= formatted[4];
+    }
+    format_ns = test_now_ns() - start;
+
+    start = test_now_ns();
+    for (long i = 0; i < iterations; i++)
+    {
+        int minute = i % 1441;
+        snprintf(formatted, sizeof(formatted), "%02d:%02d", minute / 60, minute % 60);
+        sink ^= formatted[4];
+    }
+    snprintf_ns = test_now_ns() - start;
+
+    TEST_CHECK(parse_sum == strptime_sum);
+
+    printf("%ld times\n", iterations);
+    report("parse_daytime", parse_ns, iterations);
+    report("strptime", strptime_ns, iterations);
+    report("format_daytime_hhmm", format_ns, iterations);
+    report("snprintf", snprintf_ns, iterations);
+
+    printf("stack peak\n");
+    printf("%-28s %10ld bytes\n", "parse_daytime", stack_peak(probe_parse_daytime));
+    printf("%-28s %10ld bytes\n", "strptime", stack_peak(probe_strptime));
+    printf("%-28s %10ld bytes\n", "format_daytime_hhmm", stack_peak(probe_format_daytime_hhmm));
+    printf("%-28s %10ld bytes\n", "snprintf", stack_peak(probe_snprintf));
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,57 @@
+#ifndef _TEST_H
+#define _TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*supporto minimo per i test su host: le verifiche fallite vengono stampate e contate,
+  il test ritorna TEST_RESULT() come codice di uscita per ctest*/
+
+static int test_failures = 0;
+
+#define TEST_CHECK(cond)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(cond))                                                            \
+        {                                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define TEST_RESULT() (test_failures ? EXIT_FAILURE : EXIT_SUCCESS)
+
+/*generatore pseudocasuale con seme fisso, i test e i benchmark sono riproducibili*/
+
+static uint32_t test_random_state = 0x12345678;
+
+static inline uint32_t test_random(void)
+{
+    test_random_state ^= test_random_state << 13;
+    test_random_state ^= test_random_state >> 17;
+    test_random_state ^= test_random_state << 5;
+    return test_random_state;
+}
+
+/*tempo monotono in nanosecondi, per i benchmark*/
+
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*numero di iterazioni di un benchmark, dal primo argomento o default*/
+
+static inline long test_iterations(int argc, char **argv, long fallback)
+{
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : fallback;
+
+    return iterations > 0 ? iterations : fallback;
+}
+
+#endif
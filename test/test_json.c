@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "jsonreader.h"
+#include "jsonwriter.h"
+
+#define FUZZ_ROUNDS 100000
+
+static const char *sample_command = "{\"targetTemp\": 21.55, \"mainSwitch\":true ,\"progSwitch\":false,\"note\":null,"
+                                    "\"weekProg\":{\"0\":\"07:00/08:00\",\"1\":[\"}\",{}]},\"baseTemp\":-0.5e1,\"name\":\"a\\\"b\\u00e8\\n\"}";
+
+/*scrive il messaggio usato dai test, con tutti i tipi di valore del writer*/
+
+static int write_sample(char *buffer, int size)
+{
+    json_writer_t writer;
+
+    json_writer_init(&writer, buffer, size);
+    json_writer_add_tenths(&writer, "currentTemp", 215);
+    json_writer_add_tenths(&writer, "baseTemp", -5);
+    json_writer_add_tenths(&writer, "deltaTemp", 0);
+    json_writer_add_uint(&writer, "uptime", 4294967295u);
+    json_writer_add_bool(&writer, "relayState", true);
+    json_writer_begin_array(&writer, "history");
+    json_writer_array_add_tenths(&writer, -12);
+    json_writer_array_add_uint(&writer, 7);
+    json_writer_array_add_bool(&writer, false);
+    json_writer_array_add_null(&writer);
+    json_writer_end_array(&writer);
+    json_writer_add_string(&writer, "weekProgDay0", "07:00/08:00 \"x\"\\\x01");
+    return json_writer_finish(&writer);
+}
+
+static void test_writer(void)
+{
+    static const char expected[] = "{\"currentTemp\":21.5,\"baseTemp\":-0.5,\"deltaTemp\":0,\"uptime\":4294967295,\"relayState\":true,"
+                                   "\"history\":[-1.2,7,false,null],\"weekProgDay0\":\"07:00/08:00 \\\"x\\\"\\\\\\u0001\"}";
+    char buffer[256];
+
+    TEST_CHECK(write_sample(buffer, sizeof(buffer)) == (int)strlen(expected));
+    TEST_CHECK(strcmp(buffer, expected) == 0);
+}
+
+/*con ogni dimensione di buffer insufficiente il messaggio viene scartato senza scrivere oltre la dimensione data*/
+
+static void test_writer_overflow(void)
+{
+    char buffer[256];
+    int needed = write_sample(buffer, sizeof(buffer)) + 1;
+
+    for (int size = 1; size <= needed; size++)
+    {
+        memset(buffer, '#', sizeof(buffer));
+        TEST_CHECK(write_sample(buffer, size) == (size < needed ? -1 : needed - 1));
+        for (int i = size; i < (int)sizeof(buffer); i++)
+            TEST_CHECK(buffer[i] == '#');
+    }
+}
+
+static void test_reader(void)
+{
+    char message[512];
+    json_reader_t reader;
+    json_member_t member;
+
+    strcpy(message, sample_command);
+    TEST_CHECK(json_reader_init(&reader, message));
+
+    TEST_CHECK(json_reader_next(&reader, &member) && strcmp(member.key, "targetTemp") == 0);
+    TEST_CHECK(member.type == JSON_VALUE_NUMBER && member.tenths == 216);
+    TEST_CHECK(json_reader_next(&reader, &member) && member.type == JSON_VALUE_TRUE);
+    TEST_CHECK(json_reader_next(&reader, &member) && member.type == JSON_VALUE_FALSE);
+    TEST_CHECK(json_reader_next(&reader, &member) && member.type == JSON_VALUE_NULL);
+
+    TEST_CHECK(json_reader_next(&reader, &member) && member.type == JSON_VALUE_OBJECT);
+    {
+        json_reader_t nested;
+        json_member_t day;
+
+        TEST_CHECK(json_reader_init(&nested, member.object));
+        TEST_CHECK(json_reader_next(&nested, &day) && strcmp(day.key, "0") == 0 && strcmp(day.string, "07:00/08:00") == 0);
+        TEST_CHECK(json_reader_next(&nested, &day) && day.type == JSON_VALUE_ARRAY);
+        TEST_CHECK(!json_reader_next(&nested, &day) && !nested.error);
+    }
+
+    TEST_CHECK(json_reader_next(&reader, &member) && member.tenths == -50);
+    TEST_CHECK(json_reader_next(&reader, &member) && strcmp(member.string, "a\"b\xc3\xa8\n") == 0);
+    TEST_CHECK(!json_reader_next(&reader, &member) && !reader.error);
+}
+
+static void test_reader_malformed(void)
+{
+    static const char *malformed[] = {
+        "", "[]", "{", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "{\"a\":1 \"b\":2}", "{a:1}", "{\"a\":tru}",
+        "{\"a\":\"x}", "{\"a\":\"\\q\"}", "{\"a\":\"\\u12\"}", "{\"a\":{\"b\":1}", "{\"a\":-}", "{\"a\":1.}", "{\"a\":1e}",
+    };
+
+    for (int i = 0; i < (int)(sizeof(malformed) / sizeof(malformed[0])); i++)
+    {
+        char message[64];
+        json_reader_t reader;
+        json_member_t member;
+
+        strcpy(message, malformed[i]);
+        if (json_reader_init(&reader, message))
+            while (json_reader_next(&reader, &member))
+                ;
+        TEST_CHECK(reader.error);
+    }
+}
+
+/*il messaggio del writer riletto dal reader restituisce gli stessi valori*/
+
+static void test_round_trip(void)
+{
+    char buffer[256];
+    json_reader_t reader;
+    json_member_t member;
+    int fields = 0;
+
+    write_sample(buffer, sizeof(buffer));
+    TEST_CHECK(json_reader_init(&reader, buffer));
+    while (json_reader_next(&reader, &member))
+    {
+        fields++;
+        if (strcmp(member.key, "currentTemp") == 0)
+            TEST_CHECK(member.tenths == 215);
+        else if (strcmp(member.key, "baseTemp") == 0)
+            TEST_CHECK(member.tenths == -5);
+        else if (strcmp(member.key, "weekProgDay0") == 0)
+            TEST_CHECK(strcmp(member.string, "07:00/08:00 \"x\"\\\x01") == 0);
+    }
+    TEST_CHECK(!reader.error && fields == 7);
+}
+
+/*messaggi validi troncati e con byte alterati, in un buffer della lunghezza esatta: la lettura deve terminare
+  senza uscire dal buffer, verificato dai sanitizer quando attivi*/
+
+static void test_reader_fuzz(void)
+{
+    static const char alphabet[] = "{}[]\":,\\u0e.-tfn ";
+    int length = strlen(sample_command);
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++)
+    {
+        int cut = test_random() % (length + 1);
+        char *message = malloc(cut + 1);
+        json_reader_t reader;
+        json_member_t member;
+        int fields = 0;
+
+        memcpy(message, sample_command, cut);
+        message[cut] = '\0';
+        for (int flips = test_random() % 4; flips > 0 && cut > 0; flips--)
+            message[test_random() % cut] = alphabet[test_random() % (sizeof(alphabet) - 1)];
+
+        if (json_reader_init(&reader, message))
+            while (json_reader_next(&reader, &member))
+                TEST_CHECK(++fields <= length);
+
+        free(message);
+    }
+}
+
+int main(void)
+{
+    test_writer();
+    test_writer_overflow();
+    test_reader();
+    test_reader_malformed();
+    test_round_trip();
+    test_reader_fuzz();
+
+    return TEST_RESULT();
+}
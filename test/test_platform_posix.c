@@ -0,0 +1,160 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "test.h"
+#include "platform_posix.h"
+
+#define THREADS 4
+
+static int connected = 0, disconnected = 0;
+static int mqtt_connected = 0, mqtt_disconnected = 0, mqtt_data = 0;
+static char mqtt_received[64];
+
+static void network_handler(platform_network_event_t event)
+{
+    if (event == PLATFORM_NETWORK_CONNECTED)
+        connected++;
+    else
+        disconnected++;
+}
+
+static void mqtt_handler(const platform_mqtt_event_t *event)
+{
+    if (event->type == PLATFORM_MQTT_CONNECTED)
+        mqtt_connected++;
+    else if (event->type == PLATFORM_MQTT_DISCONNECTED)
+        mqtt_disconnected++;
+    else
+    {
+        mqtt_data++;
+        TEST_CHECK(event->offset == 0 && event->length == event->total_length && event->length < (int)sizeof(mqtt_received));
+        memcpy(mqtt_received, event->data, event->length);
+        mqtt_received[event->length] = '\0';
+    }
+}
+
+static void test_clock_relay_sensors(void)
+{
+    dht_reading_t readings[DHT_MAX_SENSORS];
+
+    platform_posix_reset(1700000000);
+    platform_setup();
+    TEST_CHECK(platform_uptime_us() == 0 && platform_time() == 1700000000);
+    platform_posix_advance_us(2500000);
+    TEST_CHECK(platform_uptime_us() == 2500000 && platform_time() == 1700000002);
+
+    platform_relay_set(true);
+    platform_relay_set(true);
+    platform_relay_set(false);
+    TEST_CHECK(!platform_posix_relay() && platform_posix_relay_switches() == 2);
+    platform_led_set(true);
+    TEST_CHECK(platform_posix_led());
+
+    platform_posix_set_sensors_count(2);
+    platform_posix_set_sensor(0, 215, 450, true);
+    platform_posix_set_sensor(1, 0, 0, false);
+    TEST_CHECK(platform_sensors_count() == 2);
+    TEST_CHECK(platform_sensors_read(readings) == 1);
+    TEST_CHECK(readings[0].ok && readings[0].temp == 215 && readings[0].humi == 450 && !readings[1].ok);
+}
+
+static void test_network(void)
+{
+    platform_posix_reset(0);
+    platform_network_setup(network_handler);
+    TEST_CHECK(connected == 1 && disconnected == 0);
+
+    platform_posix_set_network(false);
+    TEST_CHECK(disconnected == 1);
+    platform_network_connect();
+    TEST_CHECK(connected == 1 && disconnected == 2);
+
+    platform_posix_set_network(true);
+    platform_network_connect();
+    TEST_CHECK(connected == 2);
+
+    platform_time_sync_start();
+    TEST_CHECK(platform_posix_time_sync_running());
+    platform_time_sync_stop();
+    TEST_CHECK(!platform_posix_time_sync_running());
+}
+
+/*broker simulato: raggiungibile con la rete disponibile, pubblicazioni registrate, messaggi consegnati solo da connessi*/
+
+static void test_mqtt(void)
+{
+    platform_mqtt_config_t config = {.uri = "mqtt://localhost", .will_topic = "t", .will_message = "{}"};
+
+    platform_posix_reset(0);
+    platform_mqtt_setup(&config, mqtt_handler);
+    TEST_CHECK(platform_mqtt_publish("t", "x", 1) < 0);
+    platform_posix_mqtt_receive("{}", 2);
+    TEST_CHECK(mqtt_data == 0);
+
+    platform_mqtt_start();
+    TEST_CHECK(mqtt_connected == 1 && platform_mqtt_subscribe("c") == 0);
+    TEST_CHECK(platform_mqtt_publish("tamba/test/dati", "{\"a\":1}xyz", 7) > 0);
+    TEST_CHECK(platform_posix_mqtt_published() == 1);
+    TEST_CHECK(strcmp(platform_posix_mqtt_last_topic(), "tamba/test/dati") == 0 && strcmp(platform_posix_mqtt_last_message(), "{\"a\":1}") == 0);
+    platform_posix_mqtt_receive("{\"b\":2}", 7);
+    TEST_CHECK(mqtt_data == 1 && strcmp(mqtt_received, "{\"b\":2}") == 0);
+
+    platform_posix_set_network(false);
+    TEST_CHECK(mqtt_disconnected == 1 && platform_mqtt_publish("t", "x", 1) < 0);
+    platform_mqtt_reconnect();
+    TEST_CHECK(mqtt_disconnected == 2);
+    platform_posix_set_network(true);
+    platform_mqtt_reconnect();
+    TEST_CHECK(mqtt_connected == 2);
+
+    platform_mqtt_stop();
+    platform_mqtt_reconnect();
+    TEST_CHECK(mqtt_connected == 2 && platform_mqtt_publish("t", "x", 1) < 0);
+}
+
+/*ogni thread ha il suo orologio e il suo relè*/
+
+static void *thread_run(void *arg)
+{
+    long index = (long)arg;
+    long *failures = malloc(sizeof(long));
+
+    *failures = 0;
+    platform_posix_reset(index * 1000);
+    for (long i = 0; i <= index; i++)
+    {
+        platform_posix_advance_us(1000000);
+        platform_relay_set(i % 2 == 0);
+    }
+
+    if (platform_time() != index * 1000 + index + 1 || platform_posix_relay_switches() != (uint32_t)index + 1)
+        (*failures)++;
+    return failures;
+}
+
+static void test_threads(void)
+{
+    pthread_t threads[THREADS];
+
+    for (long i = 0; i < THREADS; i++)
+        TEST_CHECK(pthread_create(&threads[i], NULL, thread_run, (void *)i) == 0);
+
+    for (int i = 0; i < THREADS; i++)
+    {
+        void *failures;
+
+        pthread_join(threads[i], &failures);
+        TEST_CHECK(*(long *)failures == 0);
+        free(failures);
+    }
+}
+
+int main(void)
+{
+    test_clock_relay_sensors();
+    test_network();
+    test_mqtt();
+    test_threads();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,103 @@
+#include <stdbool.h>
+
+#include "test.h"
+#include "thermocontrol.h"
+
+/*decisione del relè del thermo_task originale, riportata con le temperature in double: i rami che accendono o spengono
+  il relè aggiornano thermo_on, il ramo vuoto dell'isteresi lo lascia invariato*/
+
+static bool baseline_thermo_step(double current_temp, double target_temp, double base_temp, double delta_temp,
+                                 bool main_switch, bool prog_switch, bool in_interval, bool *thermo_on)
+{
+    if (main_switch == true && ((prog_switch == true && in_interval) || prog_switch == false) && current_temp < target_temp)
+        *thermo_on = true;
+
+    else if (main_switch == true && ((prog_switch == true && in_interval) || prog_switch == false) && *thermo_on == true && current_temp <= (target_temp + delta_temp))
+        ;
+
+    else if (current_temp < base_temp)
+        *thermo_on = true;
+
+    else
+        *thermo_on = false;
+
+    return *thermo_on;
+}
+
+/*thermo_control_relay deve decidere come il codice originale su tutta la griglia di temperature, interruttori,
+  stato della programmazione e stato precedente del relè, comprese le temperature pari alle soglie*/
+
+static void test_matches_baseline(void)
+{
+    long cases = 0;
+
+    for (int current = -50; current <= 350; current++)
+    for (int target = MIN_TARGET_TEMP; target <= MAX_TARGET_TEMP; target += 5)
+    for (int base = MIN_BASE_TEMP; base <= MAX_BASE_TEMP; base += 25)
+    for (int delta = MIN_DELTA_TEMP; delta <= MAX_DELTA_TEMP; delta++)
+    for (int flags = 0; flags < 16; flags++)
+    {
+        thermo_state_t state = {0};
+        bool main_switch = flags & 1, prog_switch = flags & 2, in_interval = flags & 4, thermo_on = flags & 8;
+        bool expected, relay;
+
+        state.current_temp = current;
+        state.target_temp = target;
+        state.base_temp = base;
+        state.delta_temp = delta;
+        state.main_switch = main_switch;
+        state.prog_switch = prog_switch;
+        state.thermo_on = thermo_on;
+
+        expected = baseline_thermo_step(current / 10.0, target / 10.0, base / 10.0, delta / 10.0, main_switch, prog_switch, in_interval, &thermo_on);
+        relay = thermo_control_relay(&state, !prog_switch || in_interval);
+        cases++;
+        TEST_CHECK(relay == expected);
+    }
+
+    printf("%ld cases compared with the original decision\n", cases);
+}
+
+/*tpi: i cambi di stato rispettano i tempi minimi salvo la soglia della temperatura di base, e sotto la soglia il relè è acceso*/
+
+static void test_tpi_min_hold(void)
+{
+    thermo_tpi_params_t params = {.cycle_s = 600, .kp = 100, .ki = 50, .min_on_s = 120, .min_off_s = 120};
+    thermo_tpi_t tpi;
+    thermo_state_t state = {.target_temp = 210, .base_temp = 120, .delta_temp = 2, .main_switch = true};
+    uint32_t next_event = 0, last_switch = 0;
+    bool relay = false, switched = false;
+
+    thermo_tpi_init(&tpi, &params);
+
+    for (uint32_t now = 0; now < 7 * 86400; now += 1 + test_random() % 60)
+    {
+        bool forced;
+        bool on;
+
+        state.current_temp = 100 + test_random() % 150;
+        forced = state.current_temp < state.base_temp;
+        on = thermo_control_tpi_relay(&tpi, &state, (now / 3600) % 3 != 0, now, &next_event);
+
+        if (forced)
+            TEST_CHECK(on);
+        else if (on != relay && switched)
+            TEST_CHECK(now - last_switch >= (relay ? params.min_on_s : params.min_off_s));
+
+        TEST_CHECK(next_event > now);
+        if (on != relay)
+        {
+            relay = on;
+            switched = true;
+            last_switch = now;
+        }
+    }
+}
+
+int main(void)
+{
+    test_matches_baseline();
+    test_tpi_min_hold();
+
+    return TEST_RESULT();
+}
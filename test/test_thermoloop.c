@@ -0,0 +1,179 @@
+#include <stdbool.h>
+
+#include "test.h"
+#include "thermoloop.h"
+
+#define TEST_MAX_LEAD_S (180 * 60)
+#define TEST_MIN_RUN_S (20 * 60)
+#define TEST_NOW 1700000000
+
+static const thermo_tpi_params_t test_tpi_params = {600, 100, 50, 120, 120};
+
+/*modello con velocità di riscaldamento di 1°C all'ora a qualsiasi temperatura*/
+
+static void train_model(optimum_start_model_t *model)
+{
+    optimum_start_run_t run;
+
+    optimum_start_init(model);
+    optimum_start_run_init(&run);
+    for (int16_t temp = 140; temp <= 200; temp += 30)
+    {
+        optimum_start_observe(model, &run, 0, temp, true, true, TEST_MIN_RUN_S);
+        optimum_start_observe(model, &run, 3600, temp + 10, false, true, TEST_MIN_RUN_S);
+    }
+}
+
+/*programmazione attiva negli intervalli o con programmazione disattivata, prossimo risveglio al cambio di stato
+  senza avvio anticipato*/
+
+static void test_prog_active(void)
+{
+    thermo_loop_t loop;
+    thermo_loop_result_t result;
+    thermo_state_t state = {.target_temp = 200, .base_temp = 120, .delta_temp = 2, .current_temp = 180, .main_switch = true, .prog_switch = true, .dht_ok = true};
+
+    thermo_loop_init(&loop, &test_tpi_params, NULL, TEST_MAX_LEAD_S, TEST_MIN_RUN_S);
+
+    thermo_loop_evaluate(&loop, &state, true, TEST_NOW + 600, TEST_NOW, 0, &result);
+    TEST_CHECK(result.prog_active && result.relay_on && !result.tpi_pending && result.next_wakeup == TEST_NOW + 600);
+
+    thermo_loop_evaluate(&loop, &state, false, TEST_NOW + 600, TEST_NOW, 0, &result);
+    TEST_CHECK(!result.prog_active && !result.relay_on && result.next_wakeup == TEST_NOW + 600);
+
+    state.prog_switch = false;
+    thermo_loop_evaluate(&loop, &state, false, (time_t)-1, TEST_NOW, 0, &result);
+    TEST_CHECK(result.prog_active && result.relay_on && result.next_wakeup == (time_t)-1);
+}
+
+/*fuori da un intervallo l'inizio successivo viene anticipato del tempo di riscaldamento previsto, non oltre il massimo*/
+
+static void test_preheat(void)
+{
+    thermo_loop_t loop;
+    thermo_loop_result_t result;
+    optimum_start_model_t model;
+    thermo_state_t state = {.target_temp = 200, .base_temp = 120, .delta_temp = 2, .current_temp = 180, .main_switch = true, .prog_switch = true, .dht_ok = true};
+    uint32_t lead;
+
+    train_model(&model);
+    lead = optimum_start_lead_s(&model, state.current_temp, state.target_temp, TEST_MAX_LEAD_S);
+    TEST_CHECK(lead > 0 && lead < TEST_MAX_LEAD_S);
+    thermo_loop_init(&loop, &test_tpi_params, &model, TEST_MAX_LEAD_S, TEST_MIN_RUN_S);
+
+    thermo_loop_evaluate(&loop, &state, false, TEST_NOW + lead + 60, TEST_NOW, 0, &result);
+    TEST_CHECK(!result.prog_active && !result.relay_on && result.next_wakeup == TEST_NOW + 60);
+
+    thermo_loop_evaluate(&loop, &state, false, TEST_NOW + lead, TEST_NOW, 0, &result);
+    TEST_CHECK(result.prog_active && result.relay_on && result.next_wakeup == TEST_NOW + lead);
+
+    state.dht_ok = false;   //senza misura valida nessun anticipo
+    thermo_loop_init(&loop, &test_tpi_params, &model, TEST_MAX_LEAD_S, TEST_MIN_RUN_S);
+    thermo_loop_evaluate(&loop, &state, false, TEST_NOW + lead, TEST_NOW, 0, &result);
+    TEST_CHECK(!result.prog_active);
+}
+
+/*il preriscaldamento partito resta attivo anche quando l'anticipo previsto scende sotto il tempo mancante, fino alla
+  temperatura target o all'inizio dell'intervallo; termina con l'impianto spento o con la programmazione modificata*/
+
+static void test_preheat_latch(void)
+{
+    thermo_loop_t loop;
+    thermo_loop_result_t result;
+    optimum_start_model_t model;
+    thermo_state_t state = {.target_temp = 200, .base_temp = 120, .delta_temp = 2, .current_temp = 180, .main_switch = true, .prog_switch = true, .dht_ok = true};
+    time_t start;
+
+    train_model(&model);
+    start = TEST_NOW + optimum_start_lead_s(&model, state.current_temp, state.target_temp, TEST_MAX_LEAD_S);
+    thermo_loop_init(&loop, &test_tpi_params, &model, TEST_MAX_LEAD_S, TEST_MIN_RUN_S);
+
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW, 0, &result);
+    TEST_CHECK(result.prog_active && result.relay_on);
+    state.thermo_on = true;
+
+    //stanza più calda del previsto, l'anticipo ricalcolato sarebbe molto più breve del tempo mancante
+    state.current_temp = 195;
+    TEST_CHECK(start - (TEST_NOW + 600) > (time_t)optimum_start_lead_s(&model, state.current_temp, state.target_temp, TEST_MAX_LEAD_S));
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW + 600, 600, &result);
+    TEST_CHECK(result.prog_active && result.relay_on && result.next_wakeup == start);
+
+    //temperatura target raggiunta prima dell'inizio: relè acceso fino al delta, poi la stanza prosegue per inerzia
+    state.current_temp = 201;
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW + 900, 900, &result);
+    TEST_CHECK(result.prog_active && result.relay_on);
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW + 960, 960, &result);
+    TEST_CHECK(!result.prog_active && !result.relay_on);
+    state.thermo_on = false;
+
+    //all'inizio dell'intervallo il preriscaldamento termina, il prossimo cambio di stato è la fine
+    thermo_loop_evaluate(&loop, &state, true, start + 3600, start, 1200, &result);
+    TEST_CHECK(result.prog_active && loop.preheat_transition == (time_t)-1);
+
+    //programmazione modificata durante il preriscaldamento, l'inizio successivo è lontano
+    state.current_temp = 180;
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW, 0, &result);
+    TEST_CHECK(result.prog_active);
+    state.current_temp = 195;
+    thermo_loop_evaluate(&loop, &state, false, start + 6 * 3600, TEST_NOW + 600, 600, &result);
+    TEST_CHECK(!result.prog_active && loop.preheat_transition == (time_t)-1);
+
+    //impianto spento durante il preriscaldamento
+    state.current_temp = 180;
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW, 0, &result);
+    state.main_switch = false;
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW + 600, 600, &result);
+    state.main_switch = true;
+    state.current_temp = 195;
+    thermo_loop_evaluate(&loop, &state, false, start, TEST_NOW + 1200, 1200, &result);
+    TEST_CHECK(!result.prog_active);
+}
+
+/*un'accensione abbastanza lunga diventa un campione del modello*/
+
+static void test_learning(void)
+{
+    thermo_loop_t loop;
+    thermo_loop_result_t result;
+    optimum_start_model_t model;
+    thermo_state_t state = {.target_temp = 200, .base_temp = 120, .delta_temp = 2, .current_temp = 180, .main_switch = true, .prog_switch = false, .dht_ok = true};
+
+    optimum_start_init(&model);
+    thermo_loop_init(&loop, &test_tpi_params, &model, TEST_MAX_LEAD_S, TEST_MIN_RUN_S);
+
+    thermo_loop_evaluate(&loop, &state, false, (time_t)-1, TEST_NOW, 0, &result);
+    TEST_CHECK(result.relay_on && !result.model_updated);
+    state.thermo_on = true;
+    state.current_temp = 210;
+    thermo_loop_evaluate(&loop, &state, false, (time_t)-1, TEST_NOW + 3600, 3600, &result);
+    TEST_CHECK(!result.relay_on && result.model_updated && model.samples == 1);
+}
+
+/*al cambio di algoritmo il regolatore tpi riparte e le sue scadenze vengono riportate*/
+
+static void test_control_mode(void)
+{
+    thermo_loop_t loop;
+    thermo_loop_result_t result;
+    thermo_state_t state = {.target_temp = 200, .base_temp = 120, .delta_temp = 2, .current_temp = 195, .main_switch = true, .prog_switch = false, .dht_ok = true, .control_mode = THERMO_CONTROL_TPI};
+
+    thermo_loop_init(&loop, &test_tpi_params, NULL, TEST_MAX_LEAD_S, TEST_MIN_RUN_S);
+
+    thermo_loop_evaluate(&loop, &state, false, (time_t)-1, TEST_NOW, 100, &result);
+    TEST_CHECK(result.tpi_pending && result.tpi_next_event > 100 && result.tpi_next_event <= 100 + test_tpi_params.cycle_s);
+
+    state.control_mode = THERMO_CONTROL_HYSTERESIS;
+    thermo_loop_evaluate(&loop, &state, false, (time_t)-1, TEST_NOW, 110, &result);
+    TEST_CHECK(!result.tpi_pending && result.relay_on);
+}
+
+int main(void)
+{
+    test_prog_active();
+    test_preheat();
+    test_preheat_latch();
+    test_learning();
+    test_control_mode();
+
+    return TEST_RESULT();
+}
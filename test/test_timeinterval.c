@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "timeinterval.h"
+#include "timestring.h"
+
+#define LIST_SIZE 64
+
+static struct tm daytime(int wday, int hour, int min, int sec)
+{
+    struct tm t = {0};
+
+    t.tm_wday = wday;
+    t.tm_hour = hour;
+    t.tm_min = min;
+    t.tm_sec = sec;
+    return t;
+}
+
+static void hhmm(char *dest, int minute)
+{
+    format_daytime_hhmm(minute, dest);
+    dest[DAYTIME_HHMM_LENGTH] = '\0';
+}
+
+static void test_day_bitmap(void)
+{
+    day_bitmap_t day;
+    char rendered[DAY_PROG_STRING_SIZE];
+    struct tm t;
+
+    init_day_bitmap(&day);
+    TEST_CHECK(insert_into_day_bitmap(&day, "08:00", "09:30"));
+    TEST_CHECK(insert_into_day_bitmap(&day, "09:00", "10:00"));     //sovrapposto, viene fuso
+    TEST_CHECK(insert_into_day_bitmap(&day, "22:00", "00:00"));     //fine a mezzanotte
+    TEST_CHECK(!insert_into_day_bitmap(&day, "10:00", "09:00"));
+    TEST_CHECK(!insert_into_day_bitmap(&day, "25:00", "26:00"));
+    TEST_CHECK(!insert_into_day_bitmap(&day, "8:00", "09:00"));
+
+    sprint_day_bitmap(&day, rendered, sizeof(rendered));
+    TEST_CHECK(strcmp(rendered, "08:00/10:00, 22:00/24:00") == 0);
+
+    t = daytime(0, 8, 0, 0);
+    TEST_CHECK(time_in_day_bitmap(&t, &day));
+    t = daytime(0, 9, 59, 59);
+    TEST_CHECK(time_in_day_bitmap(&t, &day));
+    t = daytime(0, 10, 0, 0);
+    TEST_CHECK(!time_in_day_bitmap(&t, &day));
+    t = daytime(0, 23, 59, 0);
+    TEST_CHECK(time_in_day_bitmap(&t, &day));
+}
+
+/*inserimenti oltre RENDERED_INTERVALS_PER_DAY intervalli distinti rifiutati senza modificare il giorno*/
+
+static void test_week_prog_cap(void)
+{
+    week_prog_t week;
+    char start[8], end[8];
+    char before[DAY_PROG_STRING_SIZE];
+
+    init_week_prog(&week);
+    for (int i = 0; i < RENDERED_INTERVALS_PER_DAY; i++)
+    {
+        hhmm(start, i * 60);
+        hhmm(end, i * 60 + 30);
+        TEST_CHECK(insert_into_week_prog(&week, 1, start, end));
+    }
+
+    strcpy(before, week_prog_day_string(&week, 1));
+    TEST_CHECK(!insert_into_week_prog(&week, 1, "05:40", "05:50"));
+    TEST_CHECK(strcmp(before, week_prog_day_string(&week, 1)) == 0);
+    TEST_CHECK(insert_into_week_prog(&week, 1, "05:30", "06:00"));  //fonde due intervalli, il conteggio scende
+    TEST_CHECK(insert_into_week_prog(&week, 1, "05:40", "05:50"));  //già coperto
+    TEST_CHECK(!insert_into_week_prog(&week, DAYS_PER_WEEK, "05:40", "05:50"));
+}
+
+/*caricamento in blocco atomico: una lista non valida lascia la programmazione invariata*/
+
+static void test_load_week_prog(void)
+{
+    week_prog_t week;
+    const char *valid[DAYS_PER_WEEK] = {"07:00/08:00", NULL, "", NULL, NULL, NULL, "23:00/00:00"};
+    const char *invalid[DAYS_PER_WEEK] = {"06:00/07:00", "07:00-08:00", NULL, NULL, NULL, NULL, NULL};
+
+    init_week_prog(&week);
+    TEST_CHECK(insert_into_week_prog(&week, 1, "12:00", "13:00"));
+    TEST_CHECK(load_week_prog(&week, valid));
+    TEST_CHECK(strcmp(week_prog_day_string(&week, 0), "07:00/08:00") == 0);
+    TEST_CHECK(strcmp(week_prog_day_string(&week, 1), "12:00/13:00") == 0);
+    TEST_CHECK(strcmp(week_prog_day_string(&week, 2), "") == 0);
+
+    TEST_CHECK(!load_week_prog(&week, invalid));
+    TEST_CHECK(strcmp(week_prog_day_string(&week, 0), "07:00/08:00") == 0);
+}
+
+/*cambi di stato: a mezzanotte conta l'ultimo minuto del giorno precedente*/
+
+static void test_next_transition(void)
+{
+    week_prog_t week;
+    struct tm t = {0};
+    time_t now, edge;
+
+    init_week_prog(&week);
+    TEST_CHECK(next_transition_after(&week, 0) == (time_t)-1);
+
+    TEST_CHECK(insert_into_week_prog(&week, 4, "22:00", "00:00"));  //giovedì fino a mezzanotte
+    TEST_CHECK(insert_into_week_prog(&week, 5, "00:00", "06:00"));  //venerdì prosegue senza cambio a mezzanotte
+
+    //1 gennaio 1970 era un giovedì
+    t.tm_year = 70;
+    t.tm_mday = 1;
+    t.tm_hour = 12;
+    t.tm_isdst = -1;
+    now = mktime(&t);
+
+    edge = next_transition_after(&week, now);
+    TEST_CHECK(edge - now == 10 * SECONDS_PER_HOUR);
+    edge = next_transition_after(&week, edge);
+    TEST_CHECK(edge - now == 18 * SECONDS_PER_HOUR);
+}
+
+/*la bitmap deve comportarsi come il backend a lista di intervalli che sostituisce, su programmazioni casuali
+  entro il limite di intervalli: stessa stringa e stesso esito delle ricerche a metà di ogni minuto*/
+
+static void test_bitmap_matches_interval_list(void)
+{
+    for (int round = 0; round < 500; round++)
+    {
+        daytime_interval_sec_t list[LIST_SIZE];
+        day_bitmap_t day;
+        char list_rendered[13 * LIST_SIZE];
+        char day_rendered[13 * LIST_SIZE];
+        int inserts = 1 + test_random() % 12;
+
+        init_interval_array(list, LIST_SIZE);
+        init_day_bitmap(&day);
+
+        for (int i = 0; i < inserts; i++)
+        {
+            char start[8], end[8];
+            int first = test_random() % MINUTES_PER_DAY;
+            int last = first + 1 + test_random() % 180;
+
+            if (last > MINUTES_PER_DAY)
+                last = MINUTES_PER_DAY;
+            hhmm(start, first);
+            hhmm(end, last % MINUTES_PER_DAY);
+
+            TEST_CHECK(insert_into_interval_array(list, start, end, LIST_SIZE) == insert_into_day_bitmap(&day, start, end));
+        }
+
+        sprint_intervals(list, LIST_SIZE, list_rendered, sizeof(list_rendered));
+        sprint_day_bitmap(&day, day_rendered, sizeof(day_rendered));
+        TEST_CHECK(strcmp(list_rendered, day_rendered) == 0);
+
+        for (int minute = 0; minute < MINUTES_PER_DAY; minute++)
+        {
+            struct tm t = daytime(0, minute / MINUTES_PER_HOUR, minute % MINUTES_PER_HOUR, 30);
+            TEST_CHECK(time_in_interval(&t, list, LIST_SIZE) == time_in_day_bitmap(&t, &day));
+        }
+    }
+}
+
+int main(void)
+{
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    test_day_bitmap();
+    test_week_prog_cap();
+    test_load_week_prog();
+    test_next_transition();
+    test_bitmap_matches_interval_list();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "timestring.h"
+
+#define FUZZ_ROUNDS 200000
+#define FUZZ_MAX_LENGTH 12
+
+/*parser di riferimento scritto direttamente dalla specifica del formato, per il confronto con parse_daytime*/
+
+static int reference_digits(const char *str, int length, int at)
+{
+    if (at + 1 >= length || str[at] < '0' || str[at] > '9' || str[at + 1] < '0' || str[at + 1] > '9')
+        return -1;
+    return (str[at] - '0') * 10 + str[at + 1] - '0';
+}
+
+static time_string_err_t reference_parse(const char *str, int *sec, int *consumed)
+{
+    int length = strlen(str);
+    int hour = reference_digits(str, length, 0);
+    int min = reference_digits(str, length, 3);
+    int seconds = 0;
+
+    if (hour < 0 || length < 3 || str[2] != ':' || min < 0)
+        return TIME_STRING_ERR_FORMAT;
+
+    *consumed = 5;
+    if (length > 5 && str[5] == ':')
+    {
+        seconds = reference_digits(str, length, 6);
+        if (seconds < 0)
+            return TIME_STRING_ERR_FORMAT;
+        *consumed = 8;
+    }
+
+    if (hour > 24 || min > 59 || seconds > 59 || (hour == 24 && min + seconds > 0))
+        return TIME_STRING_ERR_RANGE;
+
+    *sec = hour * 3600 + min * 60 + seconds;
+    return TIME_STRING_OK;
+}
+
+/*tutti gli orari validi, nei due formati, e il ritorno dalla formattazione HH:MM*/
+
+static void test_exhaustive(void)
+{
+    char str[16];
+    int sec;
+
+    for (int s = 0; s <= 86400; s++)
+    {
+        snprintf(str, sizeof(str), "%02d:%02d:%02d", s / 3600, s / 60 % 60, s % 60);
+        TEST_CHECK(parse_daytime(str, &sec, NULL) == TIME_STRING_OK && sec == s);
+    }
+
+    for (int minute = 0; minute <= 1440; minute++)
+    {
+        format_daytime_hhmm(minute, str);
+        str[DAYTIME_HHMM_LENGTH] = '\0';
+        TEST_CHECK(parse_daytime(str, &sec, NULL) == TIME_STRING_OK && sec == minute * 60);
+    }
+}
+
+static void test_errors(void)
+{
+    const char *end;
+    int sec = -1;
+
+    TEST_CHECK(parse_daytime(NULL, &sec, NULL) == TIME_STRING_ERR_NULL);
+    TEST_CHECK(parse_daytime("10:00", NULL, NULL) == TIME_STRING_ERR_NULL);
+    TEST_CHECK(parse_daytime("", &sec, NULL) == TIME_STRING_ERR_FORMAT);
+    TEST_CHECK(parse_daytime("1:00", &sec, NULL) == TIME_STRING_ERR_FORMAT);
+    TEST_CHECK(parse_daytime("10:00:", &sec, NULL) == TIME_STRING_ERR_FORMAT);
+    TEST_CHECK(parse_daytime("10:00 ", &sec, NULL) == TIME_STRING_ERR_FORMAT);
+    TEST_CHECK(parse_daytime("24:01", &sec, NULL) == TIME_STRING_ERR_RANGE);
+    TEST_CHECK(parse_daytime("10:60", &sec, NULL) == TIME_STRING_ERR_RANGE);
+    TEST_CHECK(sec == -1);   //in caso di errore la destinazione non viene toccata
+
+    TEST_CHECK(parse_daytime("07:30/08:00", &sec, &end) == TIME_STRING_OK && sec == 27000 && strcmp(end, "/08:00") == 0);
+}
+
+/*stringhe casuali da un alfabeto che rende frequenti gli orari quasi validi, in un buffer della lunghezza esatta
+  così che con i sanitizer attivi una lettura oltre il terminatore venga segnalata*/
+
+static void test_fuzz(void)
+{
+    static const char alphabet[] = "0123456789:::/ x";
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++)
+    {
+        int length = test_random() % (FUZZ_MAX_LENGTH + 1);
+        char *str = malloc(length + 1);
+        int sec = -1, expected_sec = -1, consumed = 0;
+        const char *end = NULL;
+        time_string_err_t expected, err;
+
+        for (int i = 0; i < length; i++)
+            str[i] = alphabet[test_random() % (sizeof(alphabet) - 1)];
+        str[length] = '\0';
+
+        expected = reference_parse(str, &expected_sec, &consumed);
+
+        err = parse_daytime(str, &sec, &end);
+        TEST_CHECK(err == expected);
+        if (err == TIME_STRING_OK)
+            TEST_CHECK(sec == expected_sec && end == str + consumed);
+
+        //senza endptr la stringa deve terminare dopo l'orario
+        err = parse_daytime(str, &sec, NULL);
+        if (expected != TIME_STRING_ERR_FORMAT && consumed != length)
+            expected = TIME_STRING_ERR_FORMAT;
+        TEST_CHECK(err == expected);
+
+        free(str);
+    }
+}
+
+int main(void)
+{
+    test_exhaustive();
+    test_errors();
+    test_fuzz();
+
+    return TEST_RESULT();
+}